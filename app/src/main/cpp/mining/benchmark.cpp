@@ -33,14 +33,15 @@ BenchmarkResult Benchmark::Run(Algorithm algo, int duration_ms) {
             
             switch (algo) {
                 case Algorithm::SHA256:
-                    SHA256::Hash(input.data(), input.size(), output.data());
+                    sha256_hash(input.data(), input.size(), output.data());
                     break;
                 case Algorithm::SCRYPT:
                     // Simplified Scrypt parameters for benchmark
-                    Scrypt::Hash(input.data(), input.size(), output.data(), 1024, 1, 1);
+                    scrypt_hash(input.data(), input.size(), input.data(), input.size(),
+                                1024, 1, 1, output.data(), output.size());
                     break;
                 case Algorithm::BLAKE3:
-                    Blake3::Hash(input.data(), input.size(), output.data());
+                    blake3_hash(input.data(), input.size(), output.data());
                     break;
             }
         }
@@ -1,18 +1,25 @@
 /**
- * Blake3 implementation for cryptocurrency mining
- * Simplified version focusing on single-threaded hashing
+ * BLAKE3 implementation for cryptocurrency mining
+ * Chunk tree per the BLAKE3 specification, with SIMD multi-chunk hashing
  */
 
 #include "blake3.h"
+#include "blake3_impl.h"
+#include "blake3_lanes.h"
+#include "thread_pool.h"
 #include <cstring>
 
+#if BLAKE3_HAVE_X86
+#include "cpu_features.h"
+#endif
+
 // Blake3 constants
-static const uint32_t IV[8] = {
+const uint32_t BLAKE3_IV[8] = {
     0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
     0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
 };
 
-static const uint8_t MSG_SCHEDULE[7][16] = {
+const uint8_t BLAKE3_MSG_SCHEDULE[7][16] = {
     {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
     {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
     {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
@@ -35,28 +42,38 @@ static inline void g(uint32_t state[16], int a, int b, int c, int d, uint32_t mx
     state[b] = ROTR32(state[b] ^ state[c], 7);
 }
 
-static void blake3_compress(const uint32_t chaining[8], const uint8_t block[64],
+static inline uint32_t load_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Load message block as little-endian uint32s
+static inline void load_block(const uint8_t block[64], uint32_t m[16]) {
+    for (int i = 0; i < 16; i++) {
+        m[i] = load_le32(block + i * 4);
+    }
+}
+
+// Full 16-word output; out[0..7] is the next chaining value
+static void blake3_compress(const uint32_t chaining[8], const uint32_t m[16],
                             uint64_t counter, uint32_t blockLen, uint32_t flags,
                             uint32_t out[16]) {
     uint32_t state[16];
-    uint32_t m[16];
-    
-    // Load message block as little-endian uint32s
-    for (int i = 0; i < 16; i++) {
-        m[i] = ((uint32_t)block[i*4]) |
-               ((uint32_t)block[i*4+1] << 8) |
-               ((uint32_t)block[i*4+2] << 16) |
-               ((uint32_t)block[i*4+3] << 24);
-    }
     
     // Initialize state
     for (int i = 0; i < 8; i++) {
         state[i] = chaining[i];
     }
-    state[8] = IV[0];
-    state[9] = IV[1];
-    state[10] = IV[2];
-    state[11] = IV[3];
+    state[8] = BLAKE3_IV[0];
+    state[9] = BLAKE3_IV[1];
+    state[10] = BLAKE3_IV[2];
+    state[11] = BLAKE3_IV[3];
     state[12] = (uint32_t)counter;
     state[13] = (uint32_t)(counter >> 32);
     state[14] = blockLen;
@@ -64,7 +81,7 @@ static void blake3_compress(const uint32_t chaining[8], const uint8_t block[64],
     
     // 7 rounds
     for (int round = 0; round < 7; round++) {
-        const uint8_t* schedule = MSG_SCHEDULE[round];
+        const uint8_t* schedule = BLAKE3_MSG_SCHEDULE[round];
         
         // Column step
         g(state, 0, 4, 8, 12, m[schedule[0]], m[schedule[1]]);
@@ -81,66 +98,630 @@ static void blake3_compress(const uint32_t chaining[8], const uint8_t block[64],
     
     // XOR with chaining value
     for (int i = 0; i < 8; i++) {
-        state[i] ^= state[i + 8];
-        state[i + 8] ^= chaining[i];
+        out[i] = state[i] ^ state[i + 8];
+        out[i + 8] = state[i + 8] ^ chaining[i];
     }
+}
+
+// Portable blake3_hash_many_fn, one chunk per call
+static void blake3_hash_many_portable(const uint8_t* input, const uint32_t key[8],
+                                      uint64_t counter, uint32_t flags, uint32_t (*cvs)[8]) {
+    uint32_t cv[8];
+    uint32_t m[16];
+    uint32_t out[16];
     
-    memcpy(out, state, 64);
+    memcpy(cv, key, sizeof(cv));
+    const int blocks = BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN;
+    for (int block = 0; block < blocks; block++) {
+        uint32_t blockFlags = flags;
+        if (block == 0) {
+            blockFlags |= BLAKE3_CHUNK_START;
+        }
+        if (block == blocks - 1) {
+            blockFlags |= BLAKE3_CHUNK_END;
+        }
+        load_block(input + block * BLAKE3_BLOCK_LEN, m);
+        blake3_compress(cv, m, counter, BLAKE3_BLOCK_LEN, blockFlags, out);
+        memcpy(cv, out, sizeof(cv));
+    }
+    memcpy(cvs[0], cv, sizeof(cv));
 }
 
-void blake3_hash(const uint8_t* data, size_t len, uint8_t* hash) {
-    uint32_t chaining[8];
-    uint8_t block[64];
+// One-lane traits so the portable backend shares the lane kernels
+struct Scalar {
+    typedef uint32_t T;
+    static const int LANES = 1;
+    static T set1(uint32_t x) { return x; }
+    static T add(T a, T b) { return a + b; }
+    static T xor_(T a, T b) { return a ^ b; }
+    static T and_(T a, T b) { return a & b; }
+    static T or_(T a, T b) { return a | b; }
+    template <int n> static T rotr(T x) { return ROTR32(x, n); }
+    static T load(const uint32_t* p) { return *p; }
+    static void store(uint32_t* p, T x) { *p = x; }
+};
+
+static void blake3_xof_many_portable(const uint32_t cv[8], const uint32_t block[16],
+                                     uint32_t blockLen, uint32_t flags, uint64_t counter,
+                                     uint8_t* out) {
+    blake3_lanes::xof_many<Scalar>(cv, block, blockLen, flags, counter, out);
+}
+
+static uint32_t blake3_mine_many_portable(const Blake3MineCtx* ctx, uint64_t nonce) {
+    return blake3_lanes::mine_many<Scalar>(ctx, nonce);
+}
+
+static uint32_t blake3_pow_many_portable(const Blake3PowCtx* ctx, uint64_t counter,
+                                         uint32_t (*rows)[BLAKE3_MAX_LANES]) {
+    return blake3_lanes::pow_many<Scalar>(ctx, counter, rows);
+}
+
+// Lane kernels chosen once when the library is loaded
+struct Blake3Impl {
+    const char* name;
+    blake3_hash_many_fn hashMany;
+    blake3_xof_many_fn xofMany;
+    blake3_mine_many_fn mineMany;
+    blake3_pow_many_fn powMany;
+    int lanes;
+};
+
+static Blake3Impl blake3_select_impl() {
+#if BLAKE3_HAVE_X86
+    if (cpu_has_avx2()) {
+        return { "avx2x8", blake3_hash_many_avx2, blake3_xof_many_avx2,
+                 blake3_mine_many_avx2, blake3_pow_many_avx2, 8 };
+    }
+#endif
+#if BLAKE3_HAVE_NEON
+    return { "neon4", blake3_hash_many_neon, blake3_xof_many_neon,
+             blake3_mine_many_neon, blake3_pow_many_neon, 4 };
+#else
+    return { "portable", blake3_hash_many_portable, blake3_xof_many_portable,
+             blake3_mine_many_portable, blake3_pow_many_portable, 1 };
+#endif
+}
+
+static const Blake3Impl impl = blake3_select_impl();
+
+const char* blake3_backend_name() {
+    return impl.name;
+}
+
+// A compression whose flags are only final once it is known whether it is
+// the root of the tree: the last block of a chunk, or a parent node
+struct Blake3Output {
+    uint32_t cv[8];
+    uint32_t block[16];
+    uint64_t counter;
+    uint32_t blockLen;
+    uint32_t flags;
+};
+
+static void output_chaining_value(const Blake3Output* output, uint32_t cv[8]) {
     uint32_t out[16];
+    blake3_compress(output->cv, output->block, output->counter, output->blockLen,
+                    output->flags, out);
+    memcpy(cv, out, 8 * sizeof(uint32_t));
+}
+
+static void parent_output(const uint32_t left[8], const uint32_t right[8],
+                          const uint32_t key[8], uint32_t flags, Blake3Output* output) {
+    memcpy(output->cv, key, 8 * sizeof(uint32_t));
+    memcpy(output->block, left, 8 * sizeof(uint32_t));
+    memcpy(output->block + 8, right, 8 * sizeof(uint32_t));
+    output->counter = 0;
+    output->blockLen = BLAKE3_BLOCK_LEN;
+    output->flags = flags | BLAKE3_PARENT;
+}
+
+static inline size_t chunk_len(const Blake3Ctx* ctx) {
+    return (size_t)ctx->blocksCompressed * BLAKE3_BLOCK_LEN + ctx->bufferLen;
+}
+
+static void chunk_reset(Blake3Ctx* ctx, uint64_t chunkCounter) {
+    memcpy(ctx->cv, ctx->key, sizeof(ctx->cv));
+    ctx->chunkCounter = chunkCounter;
+    memset(ctx->buffer, 0, sizeof(ctx->buffer));
+    ctx->bufferLen = 0;
+    ctx->blocksCompressed = 0;
+}
+
+static inline uint32_t chunk_start_flag(const Blake3Ctx* ctx) {
+    return ctx->blocksCompressed == 0 ? BLAKE3_CHUNK_START : 0;
+}
+
+static void chunk_update(Blake3Ctx* ctx, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        // A full block is only compressed once more input arrives, since the
+        // last block of a chunk needs CHUNK_END
+        if (ctx->bufferLen == BLAKE3_BLOCK_LEN) {
+            uint32_t m[16];
+            uint32_t out[16];
+            load_block(ctx->buffer, m);
+            blake3_compress(ctx->cv, m, ctx->chunkCounter, BLAKE3_BLOCK_LEN,
+                            ctx->flags | chunk_start_flag(ctx), out);
+            memcpy(ctx->cv, out, sizeof(ctx->cv));
+            ctx->blocksCompressed++;
+            memset(ctx->buffer, 0, sizeof(ctx->buffer));
+            ctx->bufferLen = 0;
+        }
+        
+        size_t take = BLAKE3_BLOCK_LEN - ctx->bufferLen;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(ctx->buffer + ctx->bufferLen, data, take);
+        ctx->bufferLen += (uint8_t)take;
+        data += take;
+        len -= take;
+    }
+}
+
+static void chunk_output(const Blake3Ctx* ctx, Blake3Output* output) {
+    memcpy(output->cv, ctx->cv, sizeof(output->cv));
+    load_block(ctx->buffer, output->block);
+    output->counter = ctx->chunkCounter;
+    output->blockLen = ctx->bufferLen;
+    output->flags = ctx->flags | chunk_start_flag(ctx) | BLAKE3_CHUNK_END;
+}
+
+// Push the chaining value of a completed chunk. totalChunks is the number of
+// chunks completed so far; each trailing zero bit closes a subtree whose
+// left half is on the stack.
+static void push_chunk_cv(Blake3Ctx* ctx, const uint32_t chunkCv[8], uint64_t totalChunks) {
+    uint32_t cv[8];
+    memcpy(cv, chunkCv, sizeof(cv));
     
-    memcpy(chaining, IV, sizeof(IV));
-    
-    // Flags
-    const uint32_t CHUNK_START = 1;
-    const uint32_t CHUNK_END = 2;
-    const uint32_t ROOT = 8;
-    
-    if (len == 0) {
-        // Empty input
-        memset(block, 0, 64);
-        blake3_compress(chaining, block, 0, 0, CHUNK_START | CHUNK_END | ROOT, out);
-    } else if (len <= 64) {
-        // Single block
-        memset(block, 0, 64);
-        memcpy(block, data, len);
-        blake3_compress(chaining, block, 0, (uint32_t)len, CHUNK_START | CHUNK_END | ROOT, out);
-    } else {
-        // Multiple blocks - simplified: just process first and last
-        // For real mining, implement full tree structure
+    while ((totalChunks & 1) == 0) {
+        Blake3Output parent;
+        parent_output(ctx->cvStack[--ctx->cvStackLen], cv, ctx->key, ctx->flags, &parent);
+        output_chaining_value(&parent, cv);
+        totalChunks >>= 1;
+    }
+    memcpy(ctx->cvStack[ctx->cvStackLen++], cv, sizeof(cv));
+}
+
+static void blake3_init_with(Blake3Ctx* ctx, const uint32_t key[8], uint32_t flags) {
+    memcpy(ctx->key, key, sizeof(ctx->key));
+    ctx->flags = flags;
+    ctx->cvStackLen = 0;
+    chunk_reset(ctx, 0);
+}
+
+void blake3_init(Blake3Ctx* ctx) {
+    blake3_init_with(ctx, BLAKE3_IV, 0);
+}
+
+void blake3_init_keyed(Blake3Ctx* ctx, const uint8_t key[BLAKE3_KEY_LEN]) {
+    uint32_t keyWords[8];
+    for (int i = 0; i < 8; i++) {
+        keyWords[i] = load_le32(key + i * 4);
+    }
+    blake3_init_with(ctx, keyWords, BLAKE3_KEYED_HASH);
+}
+
+void blake3_init_derive_key(Blake3Ctx* ctx, const char* context) {
+    // The context string is hashed into the key the material is hashed with
+    Blake3Ctx contextCtx;
+    blake3_init_with(&contextCtx, BLAKE3_IV, BLAKE3_DERIVE_KEY_CONTEXT);
+    blake3_update(&contextCtx, (const uint8_t*)context, strlen(context));
+    uint8_t contextKey[BLAKE3_KEY_LEN];
+    blake3_final(&contextCtx, contextKey, BLAKE3_KEY_LEN);
+    
+    uint32_t keyWords[8];
+    for (int i = 0; i < 8; i++) {
+        keyWords[i] = load_le32(contextKey + i * 4);
+    }
+    blake3_init_with(ctx, keyWords, BLAKE3_DERIVE_KEY_MATERIAL);
+}
+
+void blake3_update(Blake3Ctx* ctx, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        // Finish a full chunk only now that we know it is not the last one
+        if (chunk_len(ctx) == BLAKE3_CHUNK_LEN) {
+            Blake3Output output;
+            uint32_t cv[8];
+            chunk_output(ctx, &output);
+            output_chaining_value(&output, cv);
+            uint64_t totalChunks = ctx->chunkCounter + 1;
+            push_chunk_cv(ctx, cv, totalChunks);
+            chunk_reset(ctx, totalChunks);
+        }
         
-        // First block
-        memcpy(block, data, 64);
-        blake3_compress(chaining, block, 0, 64, CHUNK_START, out);
-        memcpy(chaining, out, 32);
+        // Whole chunks followed by more input can never be the root; hash
+        // them a lane's worth at a time straight from the caller's buffer
+        if (chunk_len(ctx) == 0) {
+            const size_t lanes = (size_t)impl.lanes;
+            while (len > lanes * BLAKE3_CHUNK_LEN) {
+                uint32_t cvs[BLAKE3_MAX_LANES][8];
+                uint64_t counter = ctx->chunkCounter;
+                impl.hashMany(data, ctx->key, counter, ctx->flags, cvs);
+                for (size_t i = 0; i < lanes; i++) {
+                    push_chunk_cv(ctx, cvs[i], counter + i + 1);
+                }
+                chunk_reset(ctx, counter + lanes);
+                data += lanes * BLAKE3_CHUNK_LEN;
+                len -= lanes * BLAKE3_CHUNK_LEN;
+            }
+        }
         
-        // Remaining data
-        data += 64;
-        len -= 64;
+        size_t take = BLAKE3_CHUNK_LEN - chunk_len(ctx);
+        if (take > len) {
+            take = len;
+        }
+        chunk_update(ctx, data, take);
+        data += take;
+        len -= take;
+    }
+}
+
+void blake3_final(const Blake3Ctx* ctx, uint8_t* out, size_t outLen) {
+    Blake3Reader reader;
+    blake3_reader_init(&reader, ctx);
+    blake3_reader_read(&reader, out, outLen);
+}
+
+// Top node of everything absorbed so far
+static void ctx_output(const Blake3Ctx* ctx, Blake3Output* output) {
+    chunk_output(ctx, output);
+    
+    // Fold the stacked subtrees into the current chunk, right to left
+    for (int i = ctx->cvStackLen; i > 0; i--) {
+        uint32_t cv[8];
+        output_chaining_value(output, cv);
+        parent_output(ctx->cvStack[i - 1], cv, ctx->key, ctx->flags, output);
+    }
+}
+
+// The root node is compressed once per output block, counting blocks
+// instead of chunks
+static void reader_from_output(Blake3Reader* reader, const Blake3Output* output) {
+    memcpy(reader->cv, output->cv, sizeof(reader->cv));
+    memcpy(reader->block, output->block, sizeof(reader->block));
+    reader->blockLen = output->blockLen;
+    reader->flags = output->flags | BLAKE3_ROOT;
+    reader->position = 0;
+}
+
+void blake3_reader_init(Blake3Reader* reader, const Blake3Ctx* ctx) {
+    Blake3Output output;
+    ctx_output(ctx, &output);
+    reader_from_output(reader, &output);
+}
+
+void blake3_reader_seek(Blake3Reader* reader, uint64_t position) {
+    reader->position = position;
+}
+
+void blake3_reader_read(Blake3Reader* reader, uint8_t* out, size_t len) {
+    const size_t laneBytes = (size_t)impl.lanes * BLAKE3_BLOCK_LEN;
+    
+    while (len > 0) {
+        uint64_t counter = reader->position / BLAKE3_BLOCK_LEN;
+        size_t offset = (size_t)(reader->position % BLAKE3_BLOCK_LEN);
         
-        while (len > 64) {
-            memcpy(block, data, 64);
-            blake3_compress(chaining, block, 0, 64, 0, out);
-            memcpy(chaining, out, 32);
-            data += 64;
-            len -= 64;
+        // Aligned runs of whole blocks go straight to the caller's buffer
+        if (offset == 0 && len >= laneBytes) {
+            impl.xofMany(reader->cv, reader->block, reader->blockLen, reader->flags, counter, out);
+            out += laneBytes;
+            len -= laneBytes;
+            reader->position += laneBytes;
+            continue;
         }
         
-        // Final block
-        memset(block, 0, 64);
-        memcpy(block, data, len);
-        blake3_compress(chaining, block, 0, (uint32_t)len, CHUNK_END | ROOT, out);
+        uint32_t words[16];
+        uint8_t block[BLAKE3_BLOCK_LEN];
+        blake3_compress(reader->cv, reader->block, counter, reader->blockLen, reader->flags, words);
+        for (int i = 0; i < 16; i++) {
+            store_le32(block + i * 4, words[i]);
+        }
+        size_t take = BLAKE3_BLOCK_LEN - offset;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(out, block + offset, take);
+        out += take;
+        len -= take;
+        reader->position += take;
+    }
+}
+
+void blake3_hash(const uint8_t* data, size_t len, uint8_t* hash) {
+    Blake3Ctx ctx;
+    blake3_init(&ctx);
+    blake3_update(&ctx, data, len);
+    blake3_final(&ctx, hash, BLAKE3_OUT_LEN);
+}
+
+// Bytes in the left subtree of a node over len bytes: the largest power of
+// two number of chunks that still leaves at least one byte on the right
+static size_t left_subtree_len(size_t len) {
+    size_t chunks = (len - 1) / BLAKE3_CHUNK_LEN;
+    size_t left = 1;
+    while (left * 2 <= chunks) {
+        left *= 2;
+    }
+    return left * BLAKE3_CHUNK_LEN;
+}
+
+// Threads for each child of a node over len bytes, shared out by the size
+// of each half
+static void split_threads(size_t len, size_t left, int threads, int* leftThreads,
+                          int* rightThreads) {
+    *leftThreads = (int)((uint64_t)threads * left / len);
+    if (*leftThreads < 1) {
+        *leftThreads = 1;
     }
+    *rightThreads = threads - *leftThreads > 1 ? threads - *leftThreads : 1;
+}
+
+// A subtree hashed whole on one thread
+struct Blake3Subtree {
+    const uint8_t* input;
+    size_t len;
+    uint64_t chunkCounter;
+    uint32_t cv[8];
+};
+
+// Split the node over input until each part gets one thread or is too
+// small to split, appending the parts to subtrees in input order. Returns
+// the number appended.
+static int collect_subtrees(const uint8_t* input, size_t len, uint64_t chunkCounter,
+                            int threads, Blake3Subtree* subtrees) {
+    if (threads <= 1 || len <= BLAKE3_PARALLEL_MIN_LEN) {
+        subtrees->input = input;
+        subtrees->len = len;
+        subtrees->chunkCounter = chunkCounter;
+        return 1;
+    }
+    
+    size_t left = left_subtree_len(len);
+    int leftThreads, rightThreads;
+    split_threads(len, left, threads, &leftThreads, &rightThreads);
+    int count = collect_subtrees(input, left, chunkCounter, leftThreads, subtrees);
+    return count + collect_subtrees(input + left, len - left,
+                                    chunkCounter + left / BLAKE3_CHUNK_LEN, rightThreads,
+                                    subtrees + count);
+}
+
+// Chaining value of a non-root subtree starting at chunk chunkCounter. The
+// subtree is aligned to its size, so a context starting mid-stream builds
+// the same stack a fresh one would.
+static void subtree_hash(Blake3Subtree* subtree) {
+    Blake3Ctx ctx;
+    Blake3Output output;
+    blake3_init(&ctx);
+    chunk_reset(&ctx, subtree->chunkCounter);
+    blake3_update(&ctx, subtree->input, subtree->len);
+    ctx_output(&ctx, &output);
+    output_chaining_value(&output, subtree->cv);
+}
+
+static void subtree_cv(size_t len, int threads, const Blake3Subtree** next, uint32_t cv[8]);
+
+// Chaining values of both children of the node over len bytes, walking the
+// split collect_subtrees made and taking the hashed parts from *next on
+static void children_cvs(size_t len, int threads, const Blake3Subtree** next,
+                         uint32_t cvs[2][8]) {
+    size_t left = left_subtree_len(len);
+    int leftThreads, rightThreads;
+    split_threads(len, left, threads, &leftThreads, &rightThreads);
+    subtree_cv(left, leftThreads, next, cvs[0]);
+    subtree_cv(len - left, rightThreads, next, cvs[1]);
+}
+
+static void subtree_cv(size_t len, int threads, const Blake3Subtree** next, uint32_t cv[8]) {
+    if (threads <= 1 || len <= BLAKE3_PARALLEL_MIN_LEN) {
+        memcpy(cv, (*next)->cv, sizeof((*next)->cv));
+        (*next)++;
+        return;
+    }
+    
+    uint32_t cvs[2][8];
+    Blake3Output output;
+    children_cvs(len, threads, next, cvs);
+    parent_output(cvs[0], cvs[1], BLAKE3_IV, 0, &output);
+    output_chaining_value(&output, cv);
+}
+
+void blake3_hash_parallel(const uint8_t* data, size_t len, uint8_t* hash, int threads) {
+    if (len > BLAKE3_PARALLEL_MIN_LEN) {
+        threads = thread_pool_threads(threads, THREAD_POOL_MAX_THREADS);
+    }
+    if (threads <= 1 || len <= BLAKE3_PARALLEL_MIN_LEN) {
+        blake3_hash(data, len, hash);
+        return;
+    }
+    
+    // Every part gets at least one of the threads, so there are no more
+    // parts than threads. They are hashed on the pool in one batch; the
+    // parent nodes above them are few and cheap, so they run here.
+    Blake3Subtree subtrees[THREAD_POOL_MAX_THREADS];
+    int count = collect_subtrees(data, len, 0, threads, subtrees);
+    thread_pool_run(count, [&subtrees](int i) {
+        subtree_hash(&subtrees[i]);
+    });
+    
+    // Only the root differs from subtree_cv: its output is read, not chained
+    uint32_t cvs[2][8];
+    const Blake3Subtree* next = subtrees;
+    children_cvs(len, threads, &next, cvs);
     
-    // Output hash (first 32 bytes, little-endian)
+    Blake3Output root;
+    Blake3Reader reader;
+    parent_output(cvs[0], cvs[1], BLAKE3_IV, 0, &root);
+    reader_from_output(&reader, &root);
+    blake3_reader_read(&reader, hash, BLAKE3_OUT_LEN);
+}
+
+bool blake3_mine_init(Blake3MineCtx* ctx, const uint8_t* data, size_t len, int difficulty) {
+    if (len > BLAKE3_MINE_MAX_LEN) {
+        return false;
+    }
+    
+    // Whole blocks before the nonce never change
+    size_t prefixBlocks = len / BLAKE3_BLOCK_LEN;
+    memcpy(ctx->cv, BLAKE3_IV, sizeof(ctx->cv));
+    for (size_t block = 0; block < prefixBlocks; block++) {
+        uint32_t m[16];
+        uint32_t out[16];
+        load_block(data + block * BLAKE3_BLOCK_LEN, m);
+        blake3_compress(ctx->cv, m, 0, BLAKE3_BLOCK_LEN, block == 0 ? BLAKE3_CHUNK_START : 0, out);
+        memcpy(ctx->cv, out, sizeof(ctx->cv));
+    }
+    
+    // The rest of the message plus the nonce spans one or two blocks
+    size_t offset = prefixBlocks * BLAKE3_BLOCK_LEN;
+    size_t tail = len - offset + 8;
+    uint8_t message[2 * BLAKE3_BLOCK_LEN];
+    memset(message, 0, sizeof(message));
+    memcpy(message, data + offset, len - offset);
+    
+    ctx->blocks = tail > BLAKE3_BLOCK_LEN ? 2 : 1;
+    for (int block = 0; block < ctx->blocks; block++) {
+        bool last = block == ctx->blocks - 1;
+        load_block(message + block * BLAKE3_BLOCK_LEN, ctx->words[block]);
+        ctx->blockLen[block] = last ? (uint32_t)(tail - (size_t)block * BLAKE3_BLOCK_LEN)
+                                    : BLAKE3_BLOCK_LEN;
+        ctx->blockFlags[block] = 0;
+        if (prefixBlocks == 0 && block == 0) {
+            ctx->blockFlags[block] |= BLAKE3_CHUNK_START;
+        }
+        if (last) {
+            ctx->blockFlags[block] |= BLAKE3_CHUNK_END | BLAKE3_ROOT;
+        }
+    }
+    ctx->nonceWord = (int)((len - offset) / 4);
+    ctx->nonceShift = (int)(len % 4) * 8;
+    
+    // Leading zero bits of the hash bytes, as little-endian word masks
+    uint8_t mask[BLAKE3_OUT_LEN];
+    memset(mask, 0, sizeof(mask));
+    if (difficulty > BLAKE3_OUT_LEN * 8) {
+        difficulty = BLAKE3_OUT_LEN * 8;
+    }
+    for (int i = 0; i < difficulty / 8; i++) {
+        mask[i] = 0xFF;
+    }
+    if (difficulty > 0 && difficulty % 8 != 0) {
+        mask[difficulty / 8] = (uint8_t)(0xFF << (8 - difficulty % 8));
+    }
     for (int i = 0; i < 8; i++) {
-        hash[i*4]     = (uint8_t)(out[i]);
-        hash[i*4 + 1] = (uint8_t)(out[i] >> 8);
-        hash[i*4 + 2] = (uint8_t)(out[i] >> 16);
-        hash[i*4 + 3] = (uint8_t)(out[i] >> 24);
+        ctx->mask[i] = load_le32(mask + i * 4);
+    }
+    return true;
+}
+
+bool blake3_mine_scan(const Blake3MineCtx* ctx, uint64_t first, uint64_t last,
+                      uint64_t* found, uint64_t* hashes) {
+    *hashes = 0;
+    if (first > last) {
+        return false;
+    }
+    
+    const uint64_t lanes = (uint64_t)impl.lanes;
+    uint64_t done = 0;
+    for (uint64_t nonce = first; ; nonce += lanes) {
+        // The final pass may run past last; those lanes are discarded
+        uint64_t remaining = last - nonce;
+        uint64_t valid = remaining < lanes ? remaining + 1 : lanes;
+        uint32_t hits = impl.mineMany(ctx, nonce) & ((1u << valid) - 1);
+        if (hits != 0) {
+            int lane = __builtin_ctz(hits);
+            *found = nonce + (uint64_t)lane;
+            *hashes = done + (uint64_t)lane + 1;
+            return true;
+        }
+        done += valid;
+        if (remaining < lanes) {
+            break;
+        }
     }
+    
+    *hashes = done;
+    return false;
+}
+
+bool blake3_pow_init(Blake3PowCtx* ctx, const uint8_t nonce[BLAKE3_POW_NONCE_LEN],
+                     const uint8_t* header, size_t headerLen, const uint8_t target[32],
+                     int groups, int fromGroup, int toGroup) {
+    if (headerLen > BLAKE3_POW_MAX_HEADER_LEN || groups < 1 || groups > 16 ||
+        fromGroup < 0 || fromGroup >= groups || toGroup < 0 || toGroup >= groups) {
+        return false;
+    }
+    
+    // The counter is spliced into bytes 0-7 by the lane kernels
+    uint8_t message[BLAKE3_CHUNK_LEN];
+    memset(message, 0, sizeof(message));
+    memcpy(message + 8, nonce + 8, BLAKE3_POW_NONCE_LEN - 8);
+    memcpy(message + BLAKE3_POW_NONCE_LEN, header, headerLen);
+    for (int i = 0; i < BLAKE3_CHUNK_LEN / 4; i++) {
+        ctx->words[i] = load_le32(message + i * 4);
+    }
+    
+    size_t total = BLAKE3_POW_NONCE_LEN + headerLen;
+    ctx->blocks = (int)((total + BLAKE3_BLOCK_LEN - 1) / BLAKE3_BLOCK_LEN);
+    ctx->lastBlockLen = (uint32_t)(total - (size_t)(ctx->blocks - 1) * BLAKE3_BLOCK_LEN);
+    
+    // With a power-of-two chain count (at most 256) the modulo of the last
+    // two bytes is a mask on the top byte of word 7, which the lanes can
+    // test; otherwise every lane goes on to the exact check
+    ctx->chainNum = (uint32_t)(groups * groups);
+    ctx->chainIndex = (uint32_t)(fromGroup * groups + toGroup);
+    if ((ctx->chainNum & (ctx->chainNum - 1)) == 0) {
+        ctx->indexMask = (ctx->chainNum - 1) << 24;
+        ctx->indexValue = ctx->chainIndex << 24;
+    } else {
+        ctx->indexMask = 0;
+        ctx->indexValue = 0;
+    }
+    
+    memcpy(ctx->target, target, sizeof(ctx->target));
+    return true;
+}
+
+bool blake3_pow_scan(const Blake3PowCtx* ctx, uint64_t first, uint64_t last,
+                     uint64_t* found, uint8_t hash[32], uint64_t* hashes) {
+    *hashes = 0;
+    if (first > last) {
+        return false;
+    }
+    
+    const uint64_t lanes = (uint64_t)impl.lanes;
+    uint64_t done = 0;
+    for (uint64_t counter = first; ; counter += lanes) {
+        // The final pass may run past last; those lanes are discarded
+        uint64_t remaining = last - counter;
+        uint64_t valid = remaining < lanes ? remaining + 1 : lanes;
+        uint32_t rows[8][BLAKE3_MAX_LANES];
+        uint32_t candidates = impl.powMany(ctx, counter, rows) & ((1u << valid) - 1);
+        
+        while (candidates != 0) {
+            int lane = __builtin_ctz(candidates);
+            candidates &= candidates - 1;
+            
+            uint8_t digest[BLAKE3_OUT_LEN];
+            for (int i = 0; i < 8; i++) {
+                store_le32(digest + i * 4, rows[i][lane]);
+            }
+            uint32_t index = ((uint32_t)digest[30] << 8) | digest[31];
+            if (index % ctx->chainNum != ctx->chainIndex) {
+                continue;
+            }
+            if (memcmp(digest, ctx->target, BLAKE3_OUT_LEN) <= 0) {
+                *found = counter + (uint64_t)lane;
+                memcpy(hash, digest, BLAKE3_OUT_LEN);
+                *hashes = done + (uint64_t)lane + 1;
+                return true;
+            }
+        }
+        done += valid;
+        if (remaining < lanes) {
+            break;
+        }
+    }
+    
+    *hashes = done;
+    return false;
 }
@@ -4,7 +4,138 @@
 #include <cstdint>
 #include <cstddef>
 
-// Simplified Blake3 hash function
+#define BLAKE3_OUT_LEN 32
+#define BLAKE3_KEY_LEN 32
+#define BLAKE3_BLOCK_LEN 64
+#define BLAKE3_CHUNK_LEN 1024
+#define BLAKE3_MAX_DEPTH 54
+
+// Streaming BLAKE3. Input is split into 1024-byte chunks whose chaining
+// values are merged into a binary tree of parent nodes; cvStack holds the
+// roots of the completed subtrees, one per set bit of the chunk count.
+struct Blake3Ctx {
+    uint32_t key[8];
+    uint32_t flags;
+    
+    // Chunk being absorbed
+    uint32_t cv[8];
+    uint64_t chunkCounter;
+    uint8_t buffer[BLAKE3_BLOCK_LEN];   // Pending bytes of the current block
+    uint8_t bufferLen;
+    uint8_t blocksCompressed;
+    
+    uint32_t cvStack[BLAKE3_MAX_DEPTH][8];
+    uint8_t cvStackLen;
+};
+
+// Extendable output of a finalized hash. Each 64-byte output block is an
+// independent compression of the root node, so reads can start anywhere.
+struct Blake3Reader {
+    uint32_t cv[8];
+    uint32_t block[16];
+    uint32_t blockLen;
+    uint32_t flags;
+    uint64_t position;
+};
+
+void blake3_init(Blake3Ctx* ctx);
+
+// Keyed hash (MAC mode) with a 32-byte key
+void blake3_init_keyed(Blake3Ctx* ctx, const uint8_t key[BLAKE3_KEY_LEN]);
+
+// Key derivation: context is a hardcoded, globally unique string describing
+// the purpose; the key material is then fed with blake3_update
+void blake3_init_derive_key(Blake3Ctx* ctx, const char* context);
+
+void blake3_update(Blake3Ctx* ctx, const uint8_t* data, size_t len);
+
+// Write outLen bytes of output. Does not modify ctx, so more input can be
+// added and finalized again.
+void blake3_final(const Blake3Ctx* ctx, uint8_t* out, size_t outLen);
+
+// Start reading the output of ctx at position 0. Does not modify ctx.
+void blake3_reader_init(Blake3Reader* reader, const Blake3Ctx* ctx);
+void blake3_reader_seek(Blake3Reader* reader, uint64_t position);
+
+// Read the next len bytes; whole output blocks are generated several at a
+// time by the lane backend
+void blake3_reader_read(Blake3Reader* reader, uint8_t* out, size_t len);
+
+// One-shot 32-byte BLAKE3 hash
 void blake3_hash(const uint8_t* data, size_t len, uint8_t* hash);
 
+// Inputs up to this size are hashed on the calling thread only
+#define BLAKE3_PARALLEL_MIN_LEN (64 * BLAKE3_CHUNK_LEN)
+
+// One-shot 32-byte BLAKE3 hash of a large buffer. The chunk tree is split
+// into subtrees hashed on the shared thread pool with up to threads threads
+// (0 for one per CPU, capped as thread_pool_threads does) and joined with
+// parent compressions. Same result as blake3_hash.
+void blake3_hash_parallel(const uint8_t* data, size_t len, uint8_t* hash, int threads);
+
+// Longest message a mining context accepts: message and nonce fit in one chunk
+#define BLAKE3_MINE_MAX_LEN (BLAKE3_CHUNK_LEN - 8)
+
+// Nonce search over data || nonce (64-bit little endian). Every block in
+// front of the one holding the nonce is the same for all nonces, so it is
+// compressed once; each nonce then costs one compression, or two when the
+// nonce straddles a block boundary.
+struct Blake3MineCtx {
+    uint32_t cv[8];             // Chaining value after the constant prefix
+    uint32_t words[2][16];      // Remaining blocks, nonce bytes left zero
+    uint32_t blockLen[2];
+    uint32_t blockFlags[2];
+    int blocks;
+    int nonceWord;              // First word of words holding nonce bytes
+    int nonceShift;             // Bit offset of the nonce in that word
+    uint32_t mask[8];           // Hash bits that must be zero
+};
+
+// Prepare a search for hashes whose leading difficulty bits are zero.
+// Returns false if len exceeds BLAKE3_MINE_MAX_LEN.
+bool blake3_mine_init(Blake3MineCtx* ctx, const uint8_t* data, size_t len, int difficulty);
+
+// Hash nonces first..last (inclusive) several at a time and stop at the
+// first match. Returns true with *found set on success; *hashes receives the
+// number of nonces hashed either way.
+bool blake3_mine_scan(const Blake3MineCtx* ctx, uint64_t first, uint64_t last,
+                      uint64_t* found, uint64_t* hashes);
+
+// Alephium-style proof of work: BLAKE3(BLAKE3(nonce || header)) with a
+// 24-byte nonce. Bytes 0-7 of the nonce carry the searched 64-bit counter
+// (little endian); bytes 8-23 stay fixed for a search, e.g. random per worker.
+#define BLAKE3_POW_NONCE_LEN 24
+#define BLAKE3_POW_MAX_HEADER_LEN (BLAKE3_CHUNK_LEN - BLAKE3_POW_NONCE_LEN)
+
+// A hash is a solution if its last two bytes, read big-endian, modulo
+// groups * groups are the job's chain index (fromGroup * groups + toGroup)
+// and the whole hash, read big-endian, is at most the target. The nonce
+// leads the message, so no block of it is constant; the message words are
+// split once per job instead.
+struct Blake3PowCtx {
+    uint32_t words[BLAKE3_CHUNK_LEN / 4];   // nonce || header, counter bytes left zero
+    int blocks;
+    uint32_t lastBlockLen;
+    uint32_t chainNum;
+    uint32_t chainIndex;
+    uint32_t indexMask;                     // Bits of hash word 7 the lanes filter on
+    uint32_t indexValue;
+    uint8_t target[32];                     // Big-endian
+};
+
+// Returns false for an oversized header or group numbers out of range
+bool blake3_pow_init(Blake3PowCtx* ctx, const uint8_t nonce[BLAKE3_POW_NONCE_LEN],
+                     const uint8_t* header, size_t headerLen, const uint8_t target[32],
+                     int groups, int fromGroup, int toGroup);
+
+// Search counters first..last (inclusive) several at a time. Only hashes in
+// the job's chain are compared to the target. Returns true with *found and
+// hash (the final digest) set on success; *hashes receives the number of
+// counters hashed either way.
+bool blake3_pow_scan(const Blake3PowCtx* ctx, uint64_t first, uint64_t last,
+                     uint64_t* found, uint8_t hash[32], uint64_t* hashes);
+
+// Name of the lane backend selected for this CPU (e.g. "neon4")
+const char* blake3_backend_name();
+
 #endif // BLAKE3_H
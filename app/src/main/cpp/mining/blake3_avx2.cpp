@@ -0,0 +1,67 @@
+/**
+ * AVX2 BLAKE3 kernels: eight chunks, output blocks or mining nonces per
+ * pass, one per 32-bit lane.
+ * Built with -mavx2; only called after blake3.cpp has checked CPUID.
+ */
+
+#include "blake3_impl.h"
+
+#if BLAKE3_HAVE_X86
+
+#include "blake3_lanes.h"
+#include <immintrin.h>
+
+namespace {
+
+// 8 x 32-bit lanes for blake3_lanes
+struct Avx2 {
+    typedef __m256i T;
+    static const int LANES = 8;
+    
+    static inline T set1(uint32_t x) { return _mm256_set1_epi32((int)x); }
+    static inline T add(T a, T b) { return _mm256_add_epi32(a, b); }
+    static inline T xor_(T a, T b) { return _mm256_xor_si256(a, b); }
+    static inline T and_(T a, T b) { return _mm256_and_si256(a, b); }
+    static inline T or_(T a, T b) { return _mm256_or_si256(a, b); }
+    template <int n> static inline T rotr(T x) {
+        return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+    }
+    static inline T load(const uint32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static inline void store(uint32_t* p, T x) { _mm256_storeu_si256((__m256i*)p, x); }
+};
+
+// Byte-multiple rotations are a single byte shuffle
+template <> inline Avx2::T Avx2::rotr<16>(T x) {
+    return _mm256_shuffle_epi8(x, _mm256_set_epi8(
+        13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+        13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+}
+
+template <> inline Avx2::T Avx2::rotr<8>(T x) {
+    return _mm256_shuffle_epi8(x, _mm256_set_epi8(
+        12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1,
+        12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1));
+}
+
+} // namespace
+
+void blake3_hash_many_avx2(const uint8_t* input, const uint32_t key[8],
+                           uint64_t counter, uint32_t flags, uint32_t (*cvs)[8]) {
+    blake3_lanes::hash_many<Avx2>(input, key, counter, flags, cvs);
+}
+
+void blake3_xof_many_avx2(const uint32_t cv[8], const uint32_t block[16],
+                          uint32_t blockLen, uint32_t flags, uint64_t counter, uint8_t* out) {
+    blake3_lanes::xof_many<Avx2>(cv, block, blockLen, flags, counter, out);
+}
+
+uint32_t blake3_mine_many_avx2(const Blake3MineCtx* ctx, uint64_t nonce) {
+    return blake3_lanes::mine_many<Avx2>(ctx, nonce);
+}
+
+uint32_t blake3_pow_many_avx2(const Blake3PowCtx* ctx, uint64_t counter,
+                              uint32_t (*rows)[BLAKE3_MAX_LANES]) {
+    return blake3_lanes::pow_many<Avx2>(ctx, counter, rows);
+}
+
+#endif // BLAKE3_HAVE_X86
@@ -0,0 +1,70 @@
+#ifndef BLAKE3_IMPL_H
+#define BLAKE3_IMPL_H
+
+// Internal interface between blake3.cpp and the SIMD kernels
+
+#include <cstdint>
+#include <cstddef>
+#include "blake3.h"
+
+extern const uint32_t BLAKE3_IV[8];
+extern const uint8_t BLAKE3_MSG_SCHEDULE[7][16];
+
+// Domain separation flags
+#define BLAKE3_CHUNK_START          (1 << 0)
+#define BLAKE3_CHUNK_END            (1 << 1)
+#define BLAKE3_PARENT               (1 << 2)
+#define BLAKE3_ROOT                 (1 << 3)
+#define BLAKE3_KEYED_HASH           (1 << 4)
+#define BLAKE3_DERIVE_KEY_CONTEXT   (1 << 5)
+#define BLAKE3_DERIVE_KEY_MATERIAL  (1 << 6)
+
+// Hash one whole chunk per lane: chunk i starts at input + i * BLAKE3_CHUNK_LEN
+// and has chunk counter counter + i. cvs[i] receives its chaining value.
+typedef void (*blake3_hash_many_fn)(const uint8_t* input, const uint32_t key[8],
+                                    uint64_t counter, uint32_t flags, uint32_t (*cvs)[8]);
+
+// Root output blocks counter..counter + lanes - 1 of one node, written to
+// out as lanes consecutive 64-byte blocks. flags must include BLAKE3_ROOT.
+typedef void (*blake3_xof_many_fn)(const uint32_t cv[8], const uint32_t block[16],
+                                   uint32_t blockLen, uint32_t flags, uint64_t counter,
+                                   uint8_t* out);
+
+// Root hashes of ctx's message for nonces nonce..nonce + lanes - 1, one per
+// lane. Returns a bit per lane whose hash has every bit of ctx->mask clear.
+typedef uint32_t (*blake3_mine_many_fn)(const Blake3MineCtx* ctx, uint64_t nonce);
+
+// Widest lane count of any lane kernel
+#define BLAKE3_MAX_LANES 8
+
+// Double hashes of ctx's message for counters counter..counter + lanes - 1.
+// Word i of lane l's final digest goes to rows[i][l]. Returns a bit per lane
+// whose digest passes the chain index filter.
+typedef uint32_t (*blake3_pow_many_fn)(const Blake3PowCtx* ctx, uint64_t counter,
+                                       uint32_t (*rows)[BLAKE3_MAX_LANES]);
+
+// NEON is baseline on arm64 and enabled with -mfpu=neon on armeabi-v7a
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BLAKE3_HAVE_NEON 1
+void blake3_hash_many_neon(const uint8_t* input, const uint32_t key[8],
+                           uint64_t counter, uint32_t flags, uint32_t (*cvs)[8]);
+void blake3_xof_many_neon(const uint32_t cv[8], const uint32_t block[16],
+                          uint32_t blockLen, uint32_t flags, uint64_t counter, uint8_t* out);
+uint32_t blake3_mine_many_neon(const Blake3MineCtx* ctx, uint64_t nonce);
+uint32_t blake3_pow_many_neon(const Blake3PowCtx* ctx, uint64_t counter,
+                              uint32_t (*rows)[BLAKE3_MAX_LANES]);
+#endif
+
+// Built with -mavx2 (see CMakeLists.txt), selected after a CPUID check
+#if defined(__x86_64__) && defined(X86_SIMD_KERNELS)
+#define BLAKE3_HAVE_X86 1
+void blake3_hash_many_avx2(const uint8_t* input, const uint32_t key[8],
+                           uint64_t counter, uint32_t flags, uint32_t (*cvs)[8]);
+void blake3_xof_many_avx2(const uint32_t cv[8], const uint32_t block[16],
+                          uint32_t blockLen, uint32_t flags, uint64_t counter, uint8_t* out);
+uint32_t blake3_mine_many_avx2(const Blake3MineCtx* ctx, uint64_t nonce);
+uint32_t blake3_pow_many_avx2(const Blake3PowCtx* ctx, uint64_t counter,
+                              uint32_t (*rows)[BLAKE3_MAX_LANES]);
+#endif
+
+#endif // BLAKE3_IMPL_H
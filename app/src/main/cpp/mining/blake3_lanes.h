@@ -0,0 +1,318 @@
+#ifndef BLAKE3_LANES_H
+#define BLAKE3_LANES_H
+
+#include "blake3_impl.h"
+
+// Lane-parallel BLAKE3 compression, shared by the SIMD backends. Each
+// vector lane runs an independent compression; inputs are transposed so
+// that vector i holds word i of every lane.
+//
+// V provides the vector type and operations:
+//   T, LANES, set1, add, xor_, and_, or_, rotr<n>, load(const uint32_t*), store(uint32_t*, T)
+// Include this only from a translation unit compiled for V's instruction set.
+
+namespace blake3_lanes {
+
+static inline uint32_t load_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+template <typename V>
+static inline void g(typename V::T v[16], int a, int b, int c, int d,
+                     typename V::T mx, typename V::T my) {
+    v[a] = V::add(V::add(v[a], v[b]), mx);
+    v[d] = V::template rotr<16>(V::xor_(v[d], v[a]));
+    v[c] = V::add(v[c], v[d]);
+    v[b] = V::template rotr<12>(V::xor_(v[b], v[c]));
+    v[a] = V::add(V::add(v[a], v[b]), my);
+    v[d] = V::template rotr<8>(V::xor_(v[d], v[a]));
+    v[c] = V::add(v[c], v[d]);
+    v[b] = V::template rotr<7>(V::xor_(v[b], v[c]));
+}
+
+// Compress message m into chaining value cv. out[0..7] is the next
+// chaining value, out[8..15] the rest of the extended output.
+template <typename V>
+static inline void compress(const typename V::T cv[8], const typename V::T m[16],
+                            typename V::T counterLo, typename V::T counterHi,
+                            typename V::T blockLen, typename V::T flags,
+                            typename V::T out[16]) {
+    typename V::T v[16];
+    for (int i = 0; i < 8; i++) {
+        v[i] = cv[i];
+    }
+    for (int i = 0; i < 4; i++) {
+        v[8 + i] = V::set1(BLAKE3_IV[i]);
+    }
+    v[12] = counterLo;
+    v[13] = counterHi;
+    v[14] = blockLen;
+    v[15] = flags;
+    
+    for (int r = 0; r < 7; r++) {
+        const uint8_t* s = BLAKE3_MSG_SCHEDULE[r];
+        
+        // Columns, then diagonals
+        g<V>(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        g<V>(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        g<V>(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        g<V>(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        g<V>(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        g<V>(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        g<V>(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        g<V>(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    
+    for (int i = 0; i < 8; i++) {
+        out[i] = V::xor_(v[i], v[i + 8]);
+        out[i + 8] = V::xor_(v[i + 8], cv[i]);
+    }
+}
+
+// Split per-lane 64-bit counters base + lane into low and high word vectors
+template <typename V>
+static inline void counters(uint64_t base, typename V::T* lo, typename V::T* hi) {
+    uint32_t loWords[V::LANES];
+    uint32_t hiWords[V::LANES];
+    for (int lane = 0; lane < V::LANES; lane++) {
+        uint64_t counter = base + (uint64_t)lane;
+        loWords[lane] = (uint32_t)counter;
+        hiWords[lane] = (uint32_t)(counter >> 32);
+    }
+    *lo = V::load(loWords);
+    *hi = V::load(hiWords);
+}
+
+// Transpose 8 words of every lane back to one row per lane
+template <typename V>
+static inline void store_words(const typename V::T words[8], uint32_t (*out)[8]) {
+    uint32_t rows[8][V::LANES];
+    for (int i = 0; i < 8; i++) {
+        V::store(rows[i], words[i]);
+    }
+    for (int lane = 0; lane < V::LANES; lane++) {
+        for (int i = 0; i < 8; i++) {
+            out[lane][i] = rows[i][lane];
+        }
+    }
+}
+
+// blake3_hash_many_fn over V::LANES consecutive chunks
+template <typename V>
+static inline void hash_many(const uint8_t* input, const uint32_t key[8],
+                             uint64_t counter, uint32_t flags, uint32_t (*cvs)[8]) {
+    typedef typename V::T T;
+    T cv[8];
+    T m[16];
+    T out[16];
+    T counterLo, counterHi;
+    
+    counters<V>(counter, &counterLo, &counterHi);
+    for (int i = 0; i < 8; i++) {
+        cv[i] = V::set1(key[i]);
+    }
+    
+    const int blocks = BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN;
+    for (int block = 0; block < blocks; block++) {
+        // Word w of this block for every lane's chunk
+        uint32_t words[16][V::LANES];
+        for (int lane = 0; lane < V::LANES; lane++) {
+            const uint8_t* p = input + lane * BLAKE3_CHUNK_LEN + block * BLAKE3_BLOCK_LEN;
+            for (int w = 0; w < 16; w++) {
+                words[w][lane] = load_le32(p + w * 4);
+            }
+        }
+        for (int w = 0; w < 16; w++) {
+            m[w] = V::load(words[w]);
+        }
+        
+        uint32_t blockFlags = flags;
+        if (block == 0) {
+            blockFlags |= BLAKE3_CHUNK_START;
+        }
+        if (block == blocks - 1) {
+            blockFlags |= BLAKE3_CHUNK_END;
+        }
+        compress<V>(cv, m, counterLo, counterHi, V::set1(BLAKE3_BLOCK_LEN), V::set1(blockFlags), out);
+        for (int i = 0; i < 8; i++) {
+            cv[i] = out[i];
+        }
+    }
+    
+    store_words<V>(cv, cvs);
+}
+
+// blake3_xof_many_fn: every lane compresses the same node with its own
+// output block counter
+template <typename V>
+static inline void xof_many(const uint32_t cv[8], const uint32_t block[16],
+                            uint32_t blockLen, uint32_t flags, uint64_t counter,
+                            uint8_t* out) {
+    typedef typename V::T T;
+    T cvVec[8];
+    T m[16];
+    T words[16];
+    T counterLo, counterHi;
+    
+    counters<V>(counter, &counterLo, &counterHi);
+    for (int i = 0; i < 8; i++) {
+        cvVec[i] = V::set1(cv[i]);
+    }
+    for (int w = 0; w < 16; w++) {
+        m[w] = V::set1(block[w]);
+    }
+    compress<V>(cvVec, m, counterLo, counterHi, V::set1(blockLen), V::set1(flags), words);
+    
+    uint32_t rows[16][V::LANES];
+    for (int i = 0; i < 16; i++) {
+        V::store(rows[i], words[i]);
+    }
+    for (int lane = 0; lane < V::LANES; lane++) {
+        for (int i = 0; i < 16; i++) {
+            store_le32(out + lane * BLAKE3_BLOCK_LEN + i * 4, rows[i][lane]);
+        }
+    }
+}
+
+// blake3_mine_many_fn: starts from the cached prefix chaining value, so
+// only the block(s) holding the nonce are compressed. Message words are
+// shared by every lane except the two or three that hold the nonce. The
+// difficulty mask is applied to all lanes at once.
+template <typename V>
+static inline uint32_t mine_many(const Blake3MineCtx* ctx, uint64_t nonce) {
+    typedef typename V::T T;
+    T cv[8];
+    T m[16];
+    T out[16];
+    T nonceVec[3];
+    const T zero = V::set1(0);
+    
+    // An unaligned 8-byte nonce straddles up to three words
+    uint32_t nonceWords[3][V::LANES];
+    const int shift = ctx->nonceShift;
+    for (int lane = 0; lane < V::LANES; lane++) {
+        uint64_t n = nonce + (uint64_t)lane;
+        nonceWords[0][lane] = (uint32_t)(n << shift);
+        nonceWords[1][lane] = (uint32_t)(n >> (32 - shift));
+        nonceWords[2][lane] = shift != 0 ? (uint32_t)(n >> (64 - shift)) : 0;
+    }
+    for (int k = 0; k < 3; k++) {
+        nonceVec[k] = V::load(nonceWords[k]);
+    }
+    
+    for (int i = 0; i < 8; i++) {
+        cv[i] = V::set1(ctx->cv[i]);
+    }
+    
+    for (int block = 0; block < ctx->blocks; block++) {
+        const uint32_t* words = ctx->words[block];
+        for (int w = 0; w < 16; w++) {
+            m[w] = V::set1(words[w]);
+            int k = block * 16 + w - ctx->nonceWord;
+            if (k >= 0 && k < 3) {
+                m[w] = V::xor_(m[w], nonceVec[k]);
+            }
+        }
+        compress<V>(cv, m, zero, zero, V::set1(ctx->blockLen[block]),
+                    V::set1(ctx->blockFlags[block]), out);
+        for (int i = 0; i < 8; i++) {
+            cv[i] = out[i];
+        }
+    }
+    
+    T miss = zero;
+    for (int i = 0; i < 8; i++) {
+        if (ctx->mask[i] != 0) {
+            miss = V::or_(miss, V::and_(cv[i], V::set1(ctx->mask[i])));
+        }
+    }
+    
+    uint32_t lanes[V::LANES];
+    V::store(lanes, miss);
+    uint32_t hits = 0;
+    for (int lane = 0; lane < V::LANES; lane++) {
+        if (lanes[lane] == 0) {
+            hits |= 1u << lane;
+        }
+    }
+    return hits;
+}
+
+// blake3_pow_many_fn: the counter only touches words 0 and 1 of the first
+// block, and the second hash is a single block over the first digest. The
+// chain index filter compares the low bits of the last digest byte in all
+// lanes at once.
+template <typename V>
+static inline uint32_t pow_many(const Blake3PowCtx* ctx, uint64_t counter,
+                                uint32_t (*rows)[BLAKE3_MAX_LANES]) {
+    typedef typename V::T T;
+    T cv[8];
+    T m[16];
+    T out[16];
+    T counterLo, counterHi;
+    const T zero = V::set1(0);
+    
+    counters<V>(counter, &counterLo, &counterHi);
+    for (int i = 0; i < 8; i++) {
+        cv[i] = V::set1(BLAKE3_IV[i]);
+    }
+    
+    for (int block = 0; block < ctx->blocks; block++) {
+        const uint32_t* words = ctx->words + block * 16;
+        for (int w = 0; w < 16; w++) {
+            m[w] = V::set1(words[w]);
+        }
+        if (block == 0) {
+            m[0] = V::xor_(m[0], counterLo);
+            m[1] = V::xor_(m[1], counterHi);
+        }
+        
+        bool last = block == ctx->blocks - 1;
+        uint32_t flags = 0;
+        if (block == 0) {
+            flags |= BLAKE3_CHUNK_START;
+        }
+        if (last) {
+            flags |= BLAKE3_CHUNK_END | BLAKE3_ROOT;
+        }
+        uint32_t blockLen = last ? ctx->lastBlockLen : BLAKE3_BLOCK_LEN;
+        compress<V>(cv, m, zero, zero, V::set1(blockLen), V::set1(flags), out);
+        for (int i = 0; i < 8; i++) {
+            cv[i] = out[i];
+        }
+    }
+    
+    // Second hash: the 32-byte digest as one block
+    for (int i = 0; i < 8; i++) {
+        m[i] = cv[i];
+        m[8 + i] = zero;
+        cv[i] = V::set1(BLAKE3_IV[i]);
+    }
+    compress<V>(cv, m, zero, zero, V::set1(BLAKE3_OUT_LEN),
+                V::set1(BLAKE3_CHUNK_START | BLAKE3_CHUNK_END | BLAKE3_ROOT), out);
+    for (int i = 0; i < 8; i++) {
+        V::store(rows[i], out[i]);
+    }
+    
+    T miss = V::and_(V::xor_(out[7], V::set1(ctx->indexValue)), V::set1(ctx->indexMask));
+    uint32_t lanes[V::LANES];
+    V::store(lanes, miss);
+    uint32_t hits = 0;
+    for (int lane = 0; lane < V::LANES; lane++) {
+        if (lanes[lane] == 0) {
+            hits |= 1u << lane;
+        }
+    }
+    return hits;
+}
+
+} // namespace blake3_lanes
+
+#endif // BLAKE3_LANES_H
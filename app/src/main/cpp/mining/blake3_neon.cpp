@@ -0,0 +1,58 @@
+/**
+ * NEON BLAKE3 kernels: four chunks, output blocks or mining nonces per
+ * pass, one per 32-bit lane.
+ * Used on armeabi-v7a and arm64.
+ */
+
+#include "blake3_impl.h"
+
+#if BLAKE3_HAVE_NEON
+
+#include "blake3_lanes.h"
+#include <arm_neon.h>
+
+namespace {
+
+// 4 x 32-bit lanes for blake3_lanes
+struct Neon {
+    typedef uint32x4_t T;
+    static const int LANES = 4;
+    
+    static inline T set1(uint32_t x) { return vdupq_n_u32(x); }
+    static inline T add(T a, T b) { return vaddq_u32(a, b); }
+    static inline T xor_(T a, T b) { return veorq_u32(a, b); }
+    static inline T and_(T a, T b) { return vandq_u32(a, b); }
+    static inline T or_(T a, T b) { return vorrq_u32(a, b); }
+    // Shift-right-and-insert saves the OR of a shift pair
+    template <int n> static inline T rotr(T x) { return vsriq_n_u32(vshlq_n_u32(x, 32 - n), x, n); }
+    static inline T load(const uint32_t* p) { return vld1q_u32(p); }
+    static inline void store(uint32_t* p, T x) { vst1q_u32(p, x); }
+};
+
+// Rotating by 16 swaps the halfwords of each lane
+template <> inline Neon::T Neon::rotr<16>(T x) {
+    return vreinterpretq_u32_u16(vrev32q_u16(vreinterpretq_u16_u32(x)));
+}
+
+} // namespace
+
+void blake3_hash_many_neon(const uint8_t* input, const uint32_t key[8],
+                           uint64_t counter, uint32_t flags, uint32_t (*cvs)[8]) {
+    blake3_lanes::hash_many<Neon>(input, key, counter, flags, cvs);
+}
+
+void blake3_xof_many_neon(const uint32_t cv[8], const uint32_t block[16],
+                          uint32_t blockLen, uint32_t flags, uint64_t counter, uint8_t* out) {
+    blake3_lanes::xof_many<Neon>(cv, block, blockLen, flags, counter, out);
+}
+
+uint32_t blake3_mine_many_neon(const Blake3MineCtx* ctx, uint64_t nonce) {
+    return blake3_lanes::mine_many<Neon>(ctx, nonce);
+}
+
+uint32_t blake3_pow_many_neon(const Blake3PowCtx* ctx, uint64_t counter,
+                              uint32_t (*rows)[BLAKE3_MAX_LANES]) {
+    return blake3_lanes::pow_many<Neon>(ctx, counter, rows);
+}
+
+#endif // BLAKE3_HAVE_NEON
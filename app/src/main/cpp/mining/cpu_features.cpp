@@ -0,0 +1,136 @@
+/**
+ * CPUID-based feature detection for the runtime-dispatched hash kernels,
+ * and cache sizes from sysfs for sizing scratch memory
+ */
+
+#include "cpu_features.h"
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sched.h>
+
+#if defined(__x86_64__)
+
+#include <cpuid.h>
+
+bool cpu_has_shani() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1)) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & bit_SHA) != 0;
+}
+
+bool cpu_has_avx2() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+    // OS must save YMM state
+    unsigned int xcr0Lo, xcr0Hi;
+    __asm__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+    if ((xcr0Lo & 6) != 6) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & bit_AVX2) != 0;
+}
+
+#endif
+
+// First line of a sysfs attribute, without the newline
+static bool read_sysfs(const char* path, char* buf, size_t size) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    bool ok = fgets(buf, (int)size, f) != nullptr;
+    fclose(f);
+    if (ok) {
+        buf[strcspn(buf, "\n")] = '\0';
+    }
+    return ok;
+}
+
+// CPUs in a list such as "0-3,6"
+static int count_cpu_list(const char* list) {
+    int count = 0;
+    const char* p = list;
+    while (*p) {
+        int first, last, used;
+        if (sscanf(p, "%d-%d%n", &first, &last, &used) == 2) {
+            count += last - first + 1;
+        } else if (sscanf(p, "%d%n", &first, &used) == 1) {
+            count++;
+        } else {
+            break;
+        }
+        p += used;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return count;
+}
+
+// L2 share of one CPU, read from sysfs
+static size_t read_l2_per_core(int cpu) {
+    char path[128];
+    char value[256];
+    for (int index = 0; index < 8; index++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+        if (!read_sysfs(path, value, sizeof(value))) {
+            break;
+        }
+        if (strcmp(value, "2") != 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, index);
+        if (!read_sysfs(path, value, sizeof(value)) || strcmp(value, "Instruction") == 0) {
+            continue;
+        }
+        
+        // Size is given as e.g. "512K"
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/size", cpu, index);
+        unsigned long size;
+        char unit = 0;
+        if (!read_sysfs(path, value, sizeof(value)) || sscanf(value, "%lu%c", &size, &unit) < 1) {
+            return 0;
+        }
+        if (unit == 'K') {
+            size <<= 10;
+        } else if (unit == 'M') {
+            size <<= 20;
+        }
+        
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+        int sharing = read_sysfs(path, value, sizeof(value)) ? count_cpu_list(value) : 1;
+        return size / (sharing > 0 ? sharing : 1);
+    }
+    return 0;
+}
+
+// Cache topology is fixed for the life of the process, so sysfs is read
+// once for every CPU
+#define CPU_L2_MAX_CPUS 64
+
+static size_t l2PerCore[CPU_L2_MAX_CPUS];
+static std::once_flag l2Once;
+
+size_t cpu_l2_per_core() {
+    std::call_once(l2Once, [] {
+        for (int cpu = 0; cpu < CPU_L2_MAX_CPUS; cpu++) {
+            l2PerCore[cpu] = read_l2_per_core(cpu);
+        }
+    });
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= CPU_L2_MAX_CPUS) {
+        cpu = 0;
+    }
+    return l2PerCore[cpu];
+}
@@ -0,0 +1,18 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Runtime instruction-set checks for the x86_64 kernels. They live in their
+// own translation unit: the kernel files are built with -msha/-mavx2 and
+// must not execute before these have passed.
+#if defined(__x86_64__)
+bool cpu_has_shani();
+bool cpu_has_avx2();
+#endif
+
+#include <cstddef>
+
+// Bytes of L2 cache per CPU for the core the calling thread is running on:
+// the L2's size divided by the number of CPUs sharing it. 0 if unknown.
+size_t cpu_l2_per_core();
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,250 @@
+/**
+ * Stratum job template: coinbase assembly, Merkle root and block header
+ * built natively from binary job fields
+ */
+
+#include "job_template.h"
+#include "sha256.h"
+#include <cstring>
+
+static inline void store_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t load_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Deposit the low bits of value into the set bits of mask, lowest first
+static uint32_t spread_bits(uint64_t value, uint32_t mask) {
+    uint32_t out = 0;
+    while (mask != 0 && value != 0) {
+        if (value & 1) {
+            out |= mask & (0u - mask);
+        }
+        value >>= 1;
+        mask &= mask - 1;
+    }
+    return out;
+}
+
+static inline uint64_t version_count(uint32_t mask) {
+    return 1ULL << __builtin_popcount(mask);
+}
+
+static inline void sha256d(const uint8_t* data, size_t len, uint8_t hash[32]) {
+    uint8_t first[32];
+    sha256_hash(data, len, first);
+    sha256_hash(first, 32, hash);
+}
+
+bool job_template_init(JobTemplate* job,
+                       const uint8_t* coinbase1, size_t coinbase1Len,
+                       const uint8_t* extranonce1, size_t extranonce1Len,
+                       size_t extranonce2Size,
+                       const uint8_t* coinbase2, size_t coinbase2Len,
+                       const uint8_t* merkleBranch, size_t merkleBranchLen,
+                       uint32_t version, const uint8_t prevHash[32],
+                       uint32_t ntime, uint32_t nbits) {
+    if (merkleBranchLen % 32 != 0 || extranonce2Size > JOB_MAX_EXTRANONCE2) {
+        return false;
+    }
+    
+    // Everything in front of extranonce2 is absorbed once per job
+    sha256_init(&job->coinbasePrefix);
+    sha256_update(&job->coinbasePrefix, coinbase1, coinbase1Len);
+    sha256_update(&job->coinbasePrefix, extranonce1, extranonce1Len);
+    job->coinbaseSuffix.assign(coinbase2, coinbase2 + coinbase2Len);
+    job->extranonce2Size = extranonce2Size;
+    
+    job->merkleBranch.assign(merkleBranch, merkleBranch + merkleBranchLen);
+    
+    // Header fields are little-endian; Stratum sends prevhash with each
+    // 32-bit word byte-swapped relative to the header
+    memset(job->header, 0, sizeof(job->header));
+    store_le32(job->header, version);
+    for (int i = 0; i < 32; i += 4) {
+        job->header[4 + i]     = prevHash[i + 3];
+        job->header[4 + i + 1] = prevHash[i + 2];
+        job->header[4 + i + 2] = prevHash[i + 1];
+        job->header[4 + i + 3] = prevHash[i];
+    }
+    store_le32(job->header + 68, ntime);
+    store_le32(job->header + 72, nbits);
+    
+    job->versionMask = 0;
+    job->ntimeRoll = 0;
+    
+    job->nextExtranonce2.store(0, std::memory_order_relaxed);
+    job->refs.store(1, std::memory_order_relaxed);
+    return true;
+}
+
+void job_template_set_rolling(JobTemplate* job, uint32_t versionMask, uint32_t ntimeRoll) {
+    job->versionMask = versionMask;
+    job->ntimeRoll = ntimeRoll;
+}
+
+void job_template_retain(JobTemplate* job) {
+    job->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void job_template_release(JobTemplate* job) {
+    if (job->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete job;
+    }
+}
+
+bool job_template_next_extranonce2(JobTemplate* job, uint8_t* extranonce2) {
+    size_t size = job->extranonce2Size;
+    uint64_t value = job->nextExtranonce2.fetch_add(1, std::memory_order_relaxed);
+    if (size < 8 && (value >> (size * 8)) != 0) {
+        return false;
+    }
+    
+    // Big-endian, so the submitted hex reads as the counter value
+    for (size_t i = 0; i < size; i++) {
+        size_t shift = (size - 1 - i) * 8;
+        extranonce2[i] = shift < 64 ? (uint8_t)(value >> shift) : 0;
+    }
+    return true;
+}
+
+void job_template_merkle_root(const JobTemplate* job, const uint8_t* extranonce2,
+                              uint8_t root[32]) {
+    uint8_t pair[64];
+    
+    // Coinbase hash resumes from the cached prefix state
+    Sha256Ctx ctx;
+    sha256_clone(&ctx, &job->coinbasePrefix);
+    sha256_update(&ctx, extranonce2, job->extranonce2Size);
+    sha256_update(&ctx, job->coinbaseSuffix.data(), job->coinbaseSuffix.size());
+    sha256_final(&ctx, pair);
+    sha256_hash(pair, 32, pair);
+    
+    // Coinbase is always the leftmost leaf, so each step is SHA256d(node || branch)
+    for (size_t i = 0; i < job->merkleBranch.size(); i += 32) {
+        memcpy(pair + 32, job->merkleBranch.data() + i, 32);
+        sha256d(pair, 64, pair);
+    }
+    
+    memcpy(root, pair, 32);
+}
+
+void job_template_build_header(const JobTemplate* job, const uint8_t* extranonce2,
+                               uint8_t header[80]) {
+    memcpy(header, job->header, 80);
+    job_template_merkle_root(job, extranonce2, header + 36);
+}
+
+void job_worker_init(JobWorker* worker, JobTemplate* job) {
+    job_template_retain(job);
+    worker->job = job;
+    memset(worker->extranonce2, 0, sizeof(worker->extranonce2));
+    worker->groupSize = 0;
+    worker->nextVersion = 0;
+    worker->ntime = 0;
+    worker->version = 0;
+    worker->nextNonce = 1ULL << 32;  // Roll on first scan
+}
+
+void job_worker_destroy(JobWorker* worker) {
+    if (worker->job) {
+        job_template_release(worker->job);
+        worker->job = nullptr;
+    }
+}
+
+// Midstates for the next JOB_VERSION_GROUP rolled versions of worker->header.
+// midstates[0] must hold the second-block schedule of the current header.
+static void worker_next_group(JobWorker* worker) {
+    const JobTemplate* job = worker->job;
+    uint32_t base = load_le32(job->header);
+    uint64_t total = version_count(job->versionMask);
+    
+    int n = 0;
+    while (n < JOB_VERSION_GROUP && worker->nextVersion < total) {
+        // Index 0 leaves the pool's version untouched
+        uint32_t version = base ^ spread_bits(worker->nextVersion++, job->versionMask);
+        store_le32(worker->header, version);
+        if (n > 0) {
+            worker->midstates[n] = worker->midstates[0];
+        }
+        sha256d_midstate_set_first(&worker->midstates[n], worker->header);
+        worker->versions[n] = version;
+        n++;
+    }
+    worker->groupSize = n;
+    worker->nextNonce = 0;
+}
+
+// Move on to the next unsearched group: more versions, then a later ntime,
+// and only then a new extranonce2 with its Merkle root
+static bool worker_roll(JobWorker* worker) {
+    JobTemplate* job = worker->job;
+    
+    if (worker->groupSize > 0) {
+        if (worker->nextVersion < version_count(job->versionMask)) {
+            worker_next_group(worker);
+            return true;
+        }
+        if (worker->ntime - load_le32(job->header + 68) < job->ntimeRoll) {
+            worker->ntime++;
+            store_le32(worker->header + 68, worker->ntime);
+            sha256d_midstate_set_second(&worker->midstates[0], worker->header);
+            worker->nextVersion = 0;
+            worker_next_group(worker);
+            return true;
+        }
+    }
+    
+    // Nonce, version and ntime space drained: new coinbase, same everything else
+    if (!job_template_next_extranonce2(job, worker->extranonce2)) {
+        return false;
+    }
+    job_template_build_header(job, worker->extranonce2, worker->header);
+    sha256d_midstate_init(&worker->midstates[0], worker->header);
+    worker->ntime = load_le32(worker->header + 68);
+    worker->nextVersion = 0;
+    worker_next_group(worker);
+    return true;
+}
+
+JobScanResult job_worker_scan(JobWorker* worker, const uint8_t target[32], uint64_t maxHashes,
+                              uint32_t* found, uint64_t* hashes) {
+    *hashes = 0;
+    
+    if (worker->nextNonce > 0xFFFFFFFFULL && !worker_roll(worker)) {
+        return JOB_SCAN_EXHAUSTED;
+    }
+    
+    if (maxHashes == 0) {
+        return JOB_SCAN_NONE;
+    }
+    
+    // Every nonce is hashed once per midstate in the group
+    uint64_t nonces = maxHashes / worker->groupSize;
+    if (nonces == 0) {
+        nonces = 1;
+    }
+    uint64_t last = worker->nextNonce + nonces - 1;
+    if (last > 0xFFFFFFFFULL) {
+        last = 0xFFFFFFFFULL;
+    }
+    
+    int index = 0;
+    bool hit = sha256d_scan_multi(worker->midstates, worker->groupSize,
+                                  (uint32_t)worker->nextNonce, (uint32_t)last,
+                                  target, found, &index, hashes);
+    if (hit) {
+        worker->version = worker->versions[index];
+        worker->nextNonce = (uint64_t)*found + 1;
+        return JOB_SCAN_FOUND;
+    }
+    
+    worker->nextNonce = last + 1;
+    return JOB_SCAN_NONE;
+}
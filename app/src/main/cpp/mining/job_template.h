@@ -0,0 +1,100 @@
+#ifndef JOB_TEMPLATE_H
+#define JOB_TEMPLATE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
+#include "sha256.h"
+
+#define JOB_MAX_EXTRANONCE2 16
+
+// Version-rolled midstates a worker scans together
+#define JOB_VERSION_GROUP 4
+
+// Binary form of a Stratum mining.notify job, decoded once per job.
+// Only the extranonce2 bytes of the coinbase vary while mining it.
+// Shared by all worker threads mining the job and reference counted.
+struct JobTemplate {
+    Sha256Ctx coinbasePrefix;             // SHA-256 state after coinb1 || extranonce1
+    std::vector<uint8_t> coinbaseSuffix;  // coinb2
+    size_t extranonce2Size;
+    std::vector<uint8_t> merkleBranch;    // 32 bytes per branch hash, in Stratum order
+    uint8_t header[80];                   // Header with merkle root and nonce still zero
+    uint32_t versionMask;                 // Version bits the pool lets us roll (BIP 310)
+    uint32_t ntimeRoll;                   // Seconds ntime may be advanced past the job's
+    std::atomic<uint64_t> nextExtranonce2;
+    std::atomic<int> refs;
+};
+
+// Build a template from decoded job fields. prevHash is the 32 bytes of the
+// Stratum prevhash field (word-swapped as the pool sends it); version, ntime
+// and nbits are the numeric values of their hex fields.
+// Returns false if the Merkle branch is not a whole number of hashes or
+// extranonce2 is larger than JOB_MAX_EXTRANONCE2. Starts with one reference.
+bool job_template_init(JobTemplate* job,
+                       const uint8_t* coinbase1, size_t coinbase1Len,
+                       const uint8_t* extranonce1, size_t extranonce1Len,
+                       size_t extranonce2Size,
+                       const uint8_t* coinbase2, size_t coinbase2Len,
+                       const uint8_t* merkleBranch, size_t merkleBranchLen,
+                       uint32_t version, const uint8_t prevHash[32],
+                       uint32_t ntime, uint32_t nbits);
+
+// Extend each extranonce2's search space by rolling the version bits in
+// versionMask and advancing ntime by up to ntimeRoll seconds. Both default
+// to zero; set before any worker is created on the template.
+void job_template_set_rolling(JobTemplate* job, uint32_t versionMask, uint32_t ntimeRoll);
+
+void job_template_retain(JobTemplate* job);
+
+// Drop a reference; frees a heap-allocated template when it was the last
+void job_template_release(JobTemplate* job);
+
+// Allocate the next unused extranonce2 of this job. Values come from one
+// atomic counter, so no two workers ever search the same coinbase.
+// Returns false once the extranonce2 space is exhausted.
+bool job_template_next_extranonce2(JobTemplate* job, uint8_t* extranonce2);
+
+// Merkle root of the coinbase with the given extranonce2 (extranonce2Size bytes)
+void job_template_merkle_root(const JobTemplate* job, const uint8_t* extranonce2,
+                              uint8_t root[32]);
+
+// 80-byte block header for the given extranonce2, nonce bytes left zero
+void job_template_build_header(const JobTemplate* job, const uint8_t* extranonce2,
+                               uint8_t header[80]);
+
+// Per-thread search state over a shared template. Each extranonce2 is
+// searched under every rolled version and ntime before the worker takes a
+// new one, so the coinbase and Merkle path are rebuilt only then. Versions
+// are scanned JOB_VERSION_GROUP at a time, sharing the second-block schedule.
+struct JobWorker {
+    JobTemplate* job;
+    uint8_t extranonce2[JOB_MAX_EXTRANONCE2];
+    uint8_t header[80];                             // Current extranonce2 and ntime
+    Sha256dMidstate midstates[JOB_VERSION_GROUP];
+    uint32_t versions[JOB_VERSION_GROUP];
+    int groupSize;
+    uint64_t nextVersion;   // Index of the next rolled version to group
+    uint32_t ntime;         // Rolled ntime of the current midstates
+    uint32_t version;       // Version the last found nonce belongs to
+    uint64_t nextNonce;     // 2^32 once the current group is drained
+};
+
+enum JobScanResult {
+    JOB_SCAN_FOUND,
+    JOB_SCAN_NONE,
+    JOB_SCAN_EXHAUSTED    // No extranonce2 values left for this job
+};
+
+// Takes a reference on job; job_worker_destroy drops it
+void job_worker_init(JobWorker* worker, JobTemplate* job);
+void job_worker_destroy(JobWorker* worker);
+
+// Hash up to maxHashes headers. On JOB_SCAN_FOUND, *found is the nonce and
+// worker->extranonce2, worker->version and worker->ntime the fields it
+// belongs to.
+JobScanResult job_worker_scan(JobWorker* worker, const uint8_t target[32], uint64_t maxHashes,
+                              uint32_t* found, uint64_t* hashes);
+
+#endif // JOB_TEMPLATE_H
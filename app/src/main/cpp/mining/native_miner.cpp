@@ -1,11 +1,14 @@
 #include <jni.h>
 #include <string>
 #include <cstring>
+#include <chrono>
+#include <new>
 #include <android/log.h>
 #include "sha256.h"
 #include "randomx_light.h"
 #include "blake3.h"
 #include "scrypt.h"
+#include "job_template.h"
 
 #define LOG_TAG "NativeMiner"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -74,54 +77,256 @@ Java_com_meetmyartist_miner_mining_NativeMiner_mineSha256d(
     jsize headerLen = env->GetArrayLength(blockHeader);
     jbyte *headerBytes = env->GetByteArrayElements(blockHeader, nullptr);
     
+    jsize targetLen = env->GetArrayLength(target);
     jbyte *targetBytes = env->GetByteArrayElements(target, nullptr);
     
     uint8_t header[80];
+    memset(header, 0, sizeof(header));
     memcpy(header, headerBytes, headerLen < 80 ? headerLen : 80);
     
-    uint8_t hash1[32];
-    uint8_t hash2[32];
-    long hashCount = 0;
-    
-    for (uint32_t nonce = (uint32_t)startNonce; nonce <= (uint32_t)endNonce; nonce++) {
-        // Insert nonce at bytes 76-79 (little endian)
-        header[76] = (uint8_t)(nonce & 0xFF);
-        header[77] = (uint8_t)((nonce >> 8) & 0xFF);
-        header[78] = (uint8_t)((nonce >> 16) & 0xFF);
-        header[79] = (uint8_t)((nonce >> 24) & 0xFF);
-        
-        // Double SHA256
-        sha256_hash(header, 80, hash1);
-        sha256_hash(hash1, 32, hash2);
-        hashCount++;
-        
-        // Check if hash meets target (compare from end, big-endian style)
-        bool meetsTarget = true;
-        for (int i = 31; i >= 0; i--) {
-            if (hash2[i] < (uint8_t)targetBytes[i]) {
-                // Found valid nonce!
-                env->ReleaseByteArrayElements(blockHeader, headerBytes, 0);
-                env->ReleaseByteArrayElements(target, targetBytes, 0);
-                
-                jlong count = hashCount;
-                env->SetLongArrayRegion(hashCountOut, 0, 1, &count);
-                return (jlong)nonce;
-            } else if (hash2[i] > (uint8_t)targetBytes[i]) {
-                meetsTarget = false;
-                break;
-            }
-        }
-    }
+    uint8_t target32[32];
+    memset(target32, 0, sizeof(target32));
+    memcpy(target32, targetBytes, targetLen < 32 ? targetLen : 32);
     
-    env->ReleaseByteArrayElements(blockHeader, headerBytes, 0);
-    env->ReleaseByteArrayElements(target, targetBytes, 0);
+    env->ReleaseByteArrayElements(blockHeader, headerBytes, JNI_ABORT);
+    env->ReleaseByteArrayElements(target, targetBytes, JNI_ABORT);
     
-    jlong count = hashCount;
+    // Everything except the nonce is fixed for this job
+    Sha256dMidstate midstate;
+    sha256d_midstate_init(&midstate, header);
+    
+    uint32_t nonce;
+    uint64_t hashCount = 0;
+    bool found = sha256d_scan(&midstate, (uint32_t)startNonce, (uint32_t)endNonce,
+                              target32, &nonce, &hashCount);
+    
+    jlong count = (jlong)hashCount;
     env->SetLongArrayRegion(hashCountOut, 0, 1, &count);
     
+    if (found) {
+        return (jlong)nonce;
+    }
     return -1; // No valid nonce found
 }
 
+// Build a native job template from decoded Stratum job fields
+JNIEXPORT jlong JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_createJobTemplate(
+        JNIEnv *env,
+        jobject /* this */,
+        jbyteArray coinbase1,
+        jbyteArray extranonce1,
+        jint extranonce2Size,
+        jbyteArray coinbase2,
+        jbyteArray merkleBranch,
+        jint version,
+        jbyteArray prevHash,
+        jint ntime,
+        jint nbits,
+        jint versionMask,
+        jint ntimeRoll) {
+    
+    if (extranonce2Size < 0 || ntimeRoll < 0 || env->GetArrayLength(prevHash) != 32) {
+        return 0;
+    }
+    
+    JobTemplate* job = new (std::nothrow) JobTemplate();
+    if (!job) {
+        return 0;
+    }
+    
+    jsize cb1Len = env->GetArrayLength(coinbase1);
+    jsize en1Len = env->GetArrayLength(extranonce1);
+    jsize cb2Len = env->GetArrayLength(coinbase2);
+    jsize branchLen = env->GetArrayLength(merkleBranch);
+    jbyte *cb1 = env->GetByteArrayElements(coinbase1, nullptr);
+    jbyte *en1 = env->GetByteArrayElements(extranonce1, nullptr);
+    jbyte *cb2 = env->GetByteArrayElements(coinbase2, nullptr);
+    jbyte *branch = env->GetByteArrayElements(merkleBranch, nullptr);
+    jbyte *prev = env->GetByteArrayElements(prevHash, nullptr);
+    
+    bool ok = job_template_init(job,
+                                (const uint8_t*)cb1, cb1Len,
+                                (const uint8_t*)en1, en1Len,
+                                (size_t)extranonce2Size,
+                                (const uint8_t*)cb2, cb2Len,
+                                (const uint8_t*)branch, branchLen,
+                                (uint32_t)version, (const uint8_t*)prev,
+                                (uint32_t)ntime, (uint32_t)nbits);
+    
+    env->ReleaseByteArrayElements(coinbase1, cb1, JNI_ABORT);
+    env->ReleaseByteArrayElements(extranonce1, en1, JNI_ABORT);
+    env->ReleaseByteArrayElements(coinbase2, cb2, JNI_ABORT);
+    env->ReleaseByteArrayElements(merkleBranch, branch, JNI_ABORT);
+    env->ReleaseByteArrayElements(prevHash, prev, JNI_ABORT);
+    
+    if (!ok) {
+        LOGE("Invalid job template: merkle branch length %d", branchLen);
+        delete job;
+        return 0;
+    }
+    job_template_set_rolling(job, (uint32_t)versionMask, (uint32_t)ntimeRoll);
+    return (jlong)(intptr_t)job;
+}
+
+// 80-byte header for a job template and extranonce2 (nonce bytes zero)
+JNIEXPORT jbyteArray JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_jobTemplateHeader(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong handle,
+        jbyteArray extranonce2) {
+    
+    JobTemplate* job = (JobTemplate*)(intptr_t)handle;
+    if (!job || env->GetArrayLength(extranonce2) != (jsize)job->extranonce2Size) {
+        return nullptr;
+    }
+    
+    jbyte *en2 = env->GetByteArrayElements(extranonce2, nullptr);
+    uint8_t header[80];
+    job_template_build_header(job, (const uint8_t*)en2, header);
+    env->ReleaseByteArrayElements(extranonce2, en2, JNI_ABORT);
+    
+    jbyteArray result = env->NewByteArray(80);
+    env->SetByteArrayRegion(result, 0, 80, (jbyte*)header);
+    
+    return result;
+}
+
+// Drop the caller's reference to a job template
+JNIEXPORT void JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_releaseJobTemplate(
+        JNIEnv * /* env */,
+        jobject /* this */,
+        jlong handle) {
+    JobTemplate* job = (JobTemplate*)(intptr_t)handle;
+    if (job) {
+        job_template_release(job);
+    }
+}
+
+// Per-thread search state on a shared job template
+JNIEXPORT jlong JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_createJobWorker(
+        JNIEnv * /* env */,
+        jobject /* this */,
+        jlong templateHandle) {
+    
+    JobTemplate* job = (JobTemplate*)(intptr_t)templateHandle;
+    if (!job) {
+        return 0;
+    }
+    
+    JobWorker* worker = new (std::nothrow) JobWorker();
+    if (!worker) {
+        return 0;
+    }
+    job_worker_init(worker, job);
+    return (jlong)(intptr_t)worker;
+}
+
+// Scan up to maxHashes nonces, rolling extranonce2 as needed.
+// Returns the nonce found, -1 if none, or -2 once extranonce2 space is exhausted.
+JNIEXPORT jlong JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_jobWorkerScan(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong workerHandle,
+        jbyteArray target,
+        jlong maxHashes,
+        jlongArray hashCountOut) {
+    
+    JobWorker* worker = (JobWorker*)(intptr_t)workerHandle;
+    if (!worker) {
+        jlong zero = 0;
+        env->SetLongArrayRegion(hashCountOut, 0, 1, &zero);
+        return -1;
+    }
+    
+    uint8_t target32[32];
+    memset(target32, 0, sizeof(target32));
+    jsize targetLen = env->GetArrayLength(target);
+    env->GetByteArrayRegion(target, 0, targetLen < 32 ? targetLen : 32, (jbyte*)target32);
+    
+    uint32_t nonce = 0;
+    uint64_t hashCount = 0;
+    JobScanResult result = job_worker_scan(worker, target32, maxHashes > 0 ? (uint64_t)maxHashes : 0,
+                                           &nonce, &hashCount);
+    
+    jlong count = (jlong)hashCount;
+    env->SetLongArrayRegion(hashCountOut, 0, 1, &count);
+    
+    switch (result) {
+        case JOB_SCAN_FOUND:
+            return (jlong)nonce;
+        case JOB_SCAN_EXHAUSTED:
+            return -2;
+        default:
+            return -1;
+    }
+}
+
+// Extranonce2 the worker is currently searching (the one a found nonce belongs to)
+JNIEXPORT jbyteArray JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_jobWorkerExtranonce2(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong workerHandle) {
+    
+    JobWorker* worker = (JobWorker*)(intptr_t)workerHandle;
+    if (!worker) {
+        return nullptr;
+    }
+    jsize size = (jsize)worker->job->extranonce2Size;
+    
+    jbyteArray result = env->NewByteArray(size);
+    env->SetByteArrayRegion(result, 0, size, (jbyte*)worker->extranonce2);
+    
+    return result;
+}
+
+// Version the last nonce found by the worker belongs to
+JNIEXPORT jint JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_jobWorkerVersion(
+        JNIEnv * /* env */,
+        jobject /* this */,
+        jlong workerHandle) {
+    
+    JobWorker* worker = (JobWorker*)(intptr_t)workerHandle;
+    if (!worker) {
+        return 0;
+    }
+    return (jint)worker->version;
+}
+
+// Rolled ntime the worker is searching
+JNIEXPORT jint JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_jobWorkerNtime(
+        JNIEnv * /* env */,
+        jobject /* this */,
+        jlong workerHandle) {
+    
+    JobWorker* worker = (JobWorker*)(intptr_t)workerHandle;
+    if (!worker) {
+        return 0;
+    }
+    return (jint)worker->ntime;
+}
+
+// Free a worker created by createJobWorker
+JNIEXPORT void JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_releaseJobWorker(
+        JNIEnv * /* env */,
+        jobject /* this */,
+        jlong workerHandle) {
+    
+    JobWorker* worker = (JobWorker*)(intptr_t)workerHandle;
+    if (worker) {
+        job_worker_destroy(worker);
+        delete worker;
+    }
+}
+
 // Blake3 hash (fast, modern algorithm)
 JNIEXPORT jbyteArray JNICALL
 Java_com_meetmyartist_miner_mining_NativeMiner_blake3(
@@ -155,52 +360,81 @@ Java_com_meetmyartist_miner_mining_NativeMiner_mineBlake3(
         jlongArray hashCountOut) {
     
     jsize dataLen = env->GetArrayLength(blockData);
-    jbyte *dataBytes = env->GetByteArrayElements(blockData, nullptr);
-    
-    // Calculate required leading zeros from difficulty
-    int requiredZeros = difficulty / 8;
-    int remainingBits = difficulty % 8;
     
-    uint8_t data[256];
+    uint8_t data[248];
     int actualLen = dataLen < 248 ? dataLen : 248;
-    memcpy(data, dataBytes, actualLen);
+    env->GetByteArrayRegion(blockData, 0, actualLen, (jbyte*)data);
     
-    uint8_t hash[32];
-    long hashCount = 0;
+    // Constant prefix blocks are compressed once for the whole range, then
+    // nonces are hashed a SIMD lane's worth at a time
+    Blake3MineCtx ctx;
+    blake3_mine_init(&ctx, data, (size_t)actualLen, difficulty);
     
-    for (uint64_t nonce = startNonce; nonce <= (uint64_t)endNonce; nonce++) {
-        // Append nonce (8 bytes, little endian)
-        for (int i = 0; i < 8; i++) {
-            data[actualLen + i] = (uint8_t)((nonce >> (i * 8)) & 0xFF);
-        }
-        
-        blake3_hash(data, actualLen + 8, hash);
-        hashCount++;
-        
-        // Check leading zeros
-        bool valid = true;
-        for (int i = 0; i < requiredZeros && valid; i++) {
-            if (hash[i] != 0) valid = false;
-        }
-        
-        if (valid && remainingBits > 0) {
-            uint8_t mask = 0xFF << (8 - remainingBits);
-            if ((hash[requiredZeros] & mask) != 0) valid = false;
-        }
-        
-        if (valid) {
-            env->ReleaseByteArrayElements(blockData, dataBytes, 0);
-            jlong count = hashCount;
-            env->SetLongArrayRegion(hashCountOut, 0, 1, &count);
-            return (jlong)nonce;
-        }
+    uint64_t nonce = 0;
+    uint64_t hashCount = 0;
+    bool found = startNonce >= 0 && endNonce >= startNonce &&
+                 blake3_mine_scan(&ctx, (uint64_t)startNonce, (uint64_t)endNonce,
+                                  &nonce, &hashCount);
+    
+    jlong count = (jlong)hashCount;
+    env->SetLongArrayRegion(hashCountOut, 0, 1, &count);
+    
+    return found ? (jlong)nonce : -1;
+}
+
+// Alephium-style BLAKE3 PoW over nonce || header. Bytes 0-7 of the 24-byte
+// nonce are replaced by the searched counter; target is a big-endian number
+// of up to 32 bytes. Returns the counter found, or -1.
+JNIEXPORT jlong JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_mineBlake3Pow(
+        JNIEnv *env,
+        jobject /* this */,
+        jbyteArray nonce,
+        jbyteArray header,
+        jbyteArray target,
+        jint groups,
+        jint fromGroup,
+        jint toGroup,
+        jlong startNonce,
+        jlong endNonce,
+        jlongArray hashCountOut) {
+    
+    uint8_t nonce24[BLAKE3_POW_NONCE_LEN];
+    memset(nonce24, 0, sizeof(nonce24));
+    jsize nonceLen = env->GetArrayLength(nonce);
+    if (nonceLen > BLAKE3_POW_NONCE_LEN) {
+        nonceLen = BLAKE3_POW_NONCE_LEN;
     }
+    env->GetByteArrayRegion(nonce, 0, nonceLen, (jbyte*)nonce24);
+    
+    // Shorter targets are right-aligned, as the leading bytes are zero
+    uint8_t target32[32];
+    memset(target32, 0, sizeof(target32));
+    jsize targetLen = env->GetArrayLength(target);
+    if (targetLen > 32) {
+        targetLen = 32;
+    }
+    env->GetByteArrayRegion(target, 0, targetLen, (jbyte*)(target32 + 32 - targetLen));
+    
+    jsize headerLen = env->GetArrayLength(header);
+    jbyte *headerBytes = env->GetByteArrayElements(header, nullptr);
     
-    env->ReleaseByteArrayElements(blockData, dataBytes, 0);
-    jlong count = hashCount;
+    Blake3PowCtx ctx;
+    bool valid = blake3_pow_init(&ctx, nonce24, (const uint8_t*)headerBytes, (size_t)headerLen,
+                                 target32, groups, fromGroup, toGroup);
+    env->ReleaseByteArrayElements(header, headerBytes, JNI_ABORT);
+    
+    uint64_t found = 0;
+    uint64_t hashCount = 0;
+    uint8_t hash[32];
+    bool hit = valid && startNonce >= 0 && endNonce >= startNonce &&
+               blake3_pow_scan(&ctx, (uint64_t)startNonce, (uint64_t)endNonce,
+                               &found, hash, &hashCount);
+    
+    jlong count = (jlong)hashCount;
     env->SetLongArrayRegion(hashCountOut, 0, 1, &count);
     
-    return -1;
+    return hit ? (jlong)found : -1;
 }
 
 // Scrypt hash (for Litecoin)
@@ -216,10 +450,11 @@ Java_com_meetmyartist_miner_mining_NativeMiner_scrypt(
     jsize inputLen = env->GetArrayLength(input);
     jbyte *inputBytes = env->GetByteArrayElements(input, nullptr);
     
+    // p > 1 spreads its ROMix blocks over one thread per CPU
     uint8_t hash[32];
-    scrypt_hash((const uint8_t*)inputBytes, inputLen, 
-                (const uint8_t*)inputBytes, inputLen,
-                n, r, p, hash, 32);
+    scrypt_hash_parallel((const uint8_t*)inputBytes, inputLen,
+                         (const uint8_t*)inputBytes, inputLen,
+                         n, r, p, hash, 32, 0);
     
     env->ReleaseByteArrayElements(input, inputBytes, 0);
     
@@ -229,6 +464,54 @@ Java_com_meetmyartist_miner_mining_NativeMiner_scrypt(
     return result;
 }
 
+// Mine Litecoin-style scrypt(1024, 1, 1) with nonce range
+JNIEXPORT jlong JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_mineScrypt(
+        JNIEnv *env,
+        jobject /* this */,
+        jbyteArray blockHeader,
+        jbyteArray target,
+        jlong startNonce,
+        jlong endNonce,
+        jlongArray hashCountOut) {
+    
+    uint8_t header[SCRYPT_HEADER_LEN];
+    memset(header, 0, sizeof(header));
+    jsize headerLen = env->GetArrayLength(blockHeader);
+    env->GetByteArrayRegion(blockHeader, 0, headerLen < SCRYPT_HEADER_LEN ? headerLen : SCRYPT_HEADER_LEN,
+                            (jbyte*)header);
+    
+    uint8_t target32[32];
+    memset(target32, 0, sizeof(target32));
+    jsize targetLen = env->GetArrayLength(target);
+    env->GetByteArrayRegion(target, 0, targetLen < 32 ? targetLen : 32, (jbyte*)target32);
+    
+    // Key hash prefix is absorbed once; scratch memory stays with the thread
+    ScryptMineCtx ctx;
+    scrypt_mine_init(&ctx, header, 1024, 1, 1);
+    
+    uint32_t nonce = 0;
+    uint64_t hashCount = 0;
+    bool found = startNonce >= 0 && endNonce >= startNonce && endNonce <= 0xFFFFFFFFLL &&
+                 scrypt_mine_scan(&ctx, (uint32_t)startNonce, (uint32_t)endNonce,
+                                  target32, &nonce, &hashCount);
+    
+    jlong count = (jlong)hashCount;
+    env->SetLongArrayRegion(hashCountOut, 0, 1, &count);
+    
+    return found ? (jlong)nonce : -1;
+}
+
+// Scrypt time-memory tradeoff for all mining threads: 1 keeps all of V,
+// 0 picks a factor from each core's L2 size
+JNIEXPORT void JNICALL
+Java_com_meetmyartist_miner_mining_NativeMiner_setScryptTmto(
+        JNIEnv * /* env */,
+        jobject /* this */,
+        jint factor) {
+    scrypt_set_tmto(factor);
+}
+
 // RandomX light mode (CPU mining for Monero) - simplified version
 JNIEXPORT jbyteArray JNICALL
 Java_com_meetmyartist_miner_mining_NativeMiner_randomxLight(
@@ -261,7 +544,8 @@ JNIEXPORT jstring JNICALL
 Java_com_meetmyartist_miner_mining_NativeMiner_getVersion(
         JNIEnv *env,
         jobject /* this */) {
-    return env->NewStringUTF("1.0.0-native");
+    std::string version = std::string("1.0.0-native (sha256: ") + sha256_backend_name() + ")";
+    return env->NewStringUTF(version.c_str());
 }
 
 // Benchmark: measure hash rate for algorithm
@@ -272,32 +556,34 @@ Java_com_meetmyartist_miner_mining_NativeMiner_benchmarkSha256d(
         jint durationMs) {
     
     uint8_t data[80];
-    uint8_t hash1[32];
-    uint8_t hash2[32];
+    uint8_t target[32];
     
     // Fill with random-ish data
     for (int i = 0; i < 80; i++) {
         data[i] = (uint8_t)(i * 7 + 13);
     }
+    // Zero target is never met, so every batch runs to completion
+    memset(target, 0, sizeof(target));
+    
+    // Measure the same scan path that mineSha256d uses
+    Sha256dMidstate midstate;
+    sha256d_midstate_init(&midstate, data);
     
     auto start = std::chrono::high_resolution_clock::now();
-    long hashes = 0;
+    uint64_t hashes = 0;
+    uint32_t nonce = 0;
     
     while (true) {
-        // Increment nonce
-        data[76]++;
-        if (data[76] == 0) data[77]++;
-        
-        sha256_hash(data, 80, hash1);
-        sha256_hash(hash1, 32, hash2);
-        hashes++;
+        uint32_t found;
+        uint64_t batch = 0;
+        sha256d_scan(&midstate, nonce, nonce + 9999, target, &found, &batch);
+        nonce += 10000;
+        hashes += batch;
         
         // Check elapsed time every 10000 hashes
-        if (hashes % 10000 == 0) {
-            auto now = std::chrono::high_resolution_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
-            if (elapsed >= durationMs) break;
-        }
+        auto now = std::chrono::high_resolution_clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+        if (elapsed >= durationMs) break;
     }
     
     auto end = std::chrono::high_resolution_clock::now();
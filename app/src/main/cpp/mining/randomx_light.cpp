@@ -12,57 +12,17 @@
 #include <cstring>
 #include <cstdlib>
 
-// AES round keys for the scratchpad initialization
-static const uint8_t AES_ROUND_KEYS[16] = {
-    0x6a, 0x09, 0xe6, 0x67, 0xbb, 0x67, 0xae, 0x85,
-    0x3c, 0x6e, 0xf3, 0x72, 0xa5, 0x4f, 0xf5, 0x3a
-};
-
-// Simple AES-like round function (not cryptographic, just for randomization)
-static void aes_round(uint8_t state[16], const uint8_t key[16]) {
-    for (int i = 0; i < 16; i++) {
-        state[i] ^= key[i];
-        // Simple S-box substitution
-        state[i] = (state[i] * 0x9D + 0x5B) & 0xFF;
-    }
-    
-    // Row shift
-    uint8_t temp = state[1];
-    state[1] = state[5];
-    state[5] = state[9];
-    state[9] = state[13];
-    state[13] = temp;
-    
-    temp = state[2];
-    state[2] = state[10];
-    state[10] = temp;
-    temp = state[6];
-    state[6] = state[14];
-    state[14] = temp;
-    
-    temp = state[15];
-    state[15] = state[11];
-    state[11] = state[7];
-    state[7] = state[3];
-    state[3] = temp;
-}
-
-// Initialize scratchpad with pseudo-random data
-static void init_scratchpad(uint8_t* scratchpad, size_t size, 
+// Fill the scratchpad with BLAKE3 output keyed by the seed. Output blocks
+// are generated several at a time by the SIMD lanes.
+static void init_scratchpad(uint8_t* scratchpad, size_t size,
                             const uint8_t* seed, size_t seedLen) {
-    uint8_t state[16];
+    Blake3Ctx ctx;
+    blake3_init_derive_key(&ctx, "randomx_light 2024 scratchpad");
+    blake3_update(&ctx, seed, seedLen);
     
-    // Initialize state from seed
-    memset(state, 0, 16);
-    for (size_t i = 0; i < seedLen && i < 16; i++) {
-        state[i] = seed[i];
-    }
-    
-    // Fill scratchpad
-    for (size_t i = 0; i < size; i += 16) {
-        aes_round(state, AES_ROUND_KEYS);
-        memcpy(scratchpad + i, state, 16);
-    }
+    Blake3Reader reader;
+    blake3_reader_init(&reader, &ctx);
+    blake3_reader_read(&reader, scratchpad, size);
 }
 
 // Execute random program (simplified version)
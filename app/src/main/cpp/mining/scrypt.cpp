@@ -4,14 +4,26 @@
  */
 
 #include "scrypt.h"
+#include "scrypt_impl.h"
 #include "sha256.h"
+#include "cpu_features.h"
+#include "thread_pool.h"
 #include <cstring>
 #include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <unistd.h>
+#include <sys/mman.h>
 
-// HMAC-SHA256
-static void hmac_sha256(const uint8_t* key, size_t keyLen,
-                        const uint8_t* data, size_t dataLen,
-                        uint8_t* mac) {
+// HMAC-SHA256 with the ipad/opad blocks already absorbed
+struct HmacSha256Ctx {
+    Sha256Ctx inner;
+    Sha256Ctx outer;
+};
+
+static void hmac_sha256_init(HmacSha256Ctx* ctx, const uint8_t* key, size_t keyLen) {
     uint8_t k_ipad[64];
     uint8_t k_opad[64];
     uint8_t tk[32];
@@ -32,48 +44,53 @@ static void hmac_sha256(const uint8_t* key, size_t keyLen,
         k_opad[i] ^= key[i];
     }
     
-    // Inner hash: SHA256(k_ipad || data)
-    uint8_t inner[64 + 1024]; // Assuming data < 1024
-    memcpy(inner, k_ipad, 64);
-    memcpy(inner + 64, data, dataLen);
-    
+    sha256_init(&ctx->inner);
+    sha256_update(&ctx->inner, k_ipad, 64);
+    sha256_init(&ctx->outer);
+    sha256_update(&ctx->outer, k_opad, 64);
+}
+
+// Finish SHA256(k_opad || SHA256(k_ipad || data)); consumes the context
+static void hmac_sha256_final(HmacSha256Ctx* ctx, uint8_t* mac) {
     uint8_t innerHash[32];
-    sha256_hash(inner, 64 + dataLen, innerHash);
-    
-    // Outer hash: SHA256(k_opad || inner_hash)
-    uint8_t outer[96];
-    memcpy(outer, k_opad, 64);
-    memcpy(outer + 64, innerHash, 32);
-    
-    sha256_hash(outer, 96, mac);
+    sha256_final(&ctx->inner, innerHash);
+    sha256_update(&ctx->outer, innerHash, 32);
+    sha256_final(&ctx->outer, mac);
 }
 
-// PBKDF2-HMAC-SHA256
-static void pbkdf2_sha256(const uint8_t* password, size_t passwordLen,
+// PBKDF2-HMAC-SHA256 with the password's HMAC key schedule already set up
+static void pbkdf2_sha256(const HmacSha256Ctx* keyed,
                           const uint8_t* salt, size_t saltLen,
                           int iterations, uint8_t* output, size_t outputLen) {
     uint8_t U[32];
     uint8_t T[32];
-    uint8_t block[256]; // salt + 4 bytes for block number
+    uint8_t counter[4];
+    HmacSha256Ctx hmac;
+    
+    // Salt is the same for every output block
+    HmacSha256Ctx salted = *keyed;
+    sha256_update(&salted.inner, salt, saltLen);
     
     size_t outputOffset = 0;
     int blockNum = 1;
     
     while (outputOffset < outputLen) {
-        // Prepare block: salt || INT(blockNum)
-        memcpy(block, salt, saltLen);
-        block[saltLen] = (uint8_t)(blockNum >> 24);
-        block[saltLen + 1] = (uint8_t)(blockNum >> 16);
-        block[saltLen + 2] = (uint8_t)(blockNum >> 8);
-        block[saltLen + 3] = (uint8_t)blockNum;
+        counter[0] = (uint8_t)(blockNum >> 24);
+        counter[1] = (uint8_t)(blockNum >> 16);
+        counter[2] = (uint8_t)(blockNum >> 8);
+        counter[3] = (uint8_t)blockNum;
         
         // U_1 = HMAC(password, salt || INT(blockNum))
-        hmac_sha256(password, passwordLen, block, saltLen + 4, U);
+        hmac = salted;
+        sha256_update(&hmac.inner, counter, 4);
+        hmac_sha256_final(&hmac, U);
         memcpy(T, U, 32);
         
         // U_2 to U_iterations
         for (int i = 1; i < iterations; i++) {
-            hmac_sha256(password, passwordLen, U, 32, U);
+            hmac = *keyed;
+            sha256_update(&hmac.inner, U, 32);
+            hmac_sha256_final(&hmac, U);
             for (int j = 0; j < 32; j++) {
                 T[j] ^= U[j];
             }
@@ -88,6 +105,15 @@ static void pbkdf2_sha256(const uint8_t* password, size_t passwordLen,
     }
 }
 
+#if SCRYPT_HAVE_NEON
+static const scrypt_romix_fn romix = scrypt_romix_neon;
+static const scrypt_romix_lanes_fn romix_lanes = scrypt_romix_lanes_neon;
+#elif SCRYPT_HAVE_SSE2
+static const scrypt_romix_fn romix = scrypt_romix_sse2;
+static const scrypt_romix_lanes_fn romix_lanes = scrypt_romix_lanes_sse2;
+#else
+// Scalar Salsa20/8, BlockMix and ROMix, for targets without a SIMD kernel
+
 // Salsa20/8 core
 static void salsa20_8(uint32_t B[16]) {
     uint32_t x[16];
@@ -164,25 +190,37 @@ static void scrypt_block_mix(uint32_t* B, uint32_t* Y, int r) {
     }
 }
 
-// ROMix for Scrypt
-static void scrypt_romix(uint32_t* B, int r, int N, uint32_t* V, uint32_t* XY) {
+// ROMix for Scrypt (scrypt_romix_fn)
+static void scrypt_romix(uint32_t* B, int r, int N, int tmto, uint32_t* V, uint32_t* XY) {
     int blockSize = 32 * r;
     uint32_t* X = XY;
     uint32_t* Y = XY + blockSize;
+    uint32_t* T = XY + 2 * blockSize;
     
     memcpy(X, B, blockSize * sizeof(uint32_t));
     
-    // Step 1: fill V with copies of X
+    // Step 1: fill V with copies of every tmto-th X
     for (int i = 0; i < N; i++) {
-        memcpy(V + i * blockSize, X, blockSize * sizeof(uint32_t));
+        if (i % tmto == 0) {
+            memcpy(V + (size_t)(i / tmto) * blockSize, X, blockSize * sizeof(uint32_t));
+        }
         scrypt_block_mix(X, Y, r);
     }
     
-    // Step 2: mix X with random blocks from V
+    // Step 2: mix X with random blocks from V, rebuilding the ones not kept
     for (int i = 0; i < N; i++) {
         int j = X[(2 * r - 1) * 16] % N;
+        const uint32_t* v = V + (size_t)(j / tmto) * blockSize;
+        scrypt_prefetch_block(v, r);
+        if (j % tmto != 0) {
+            memcpy(T, v, blockSize * sizeof(uint32_t));
+            for (int m = j % tmto; m > 0; m--) {
+                scrypt_block_mix(T, Y, r);
+            }
+            v = T;
+        }
         for (int k = 0; k < blockSize; k++) {
-            X[k] ^= V[j * blockSize + k];
+            X[k] ^= v[k];
         }
         scrypt_block_mix(X, Y, r);
     }
@@ -190,31 +228,449 @@ static void scrypt_romix(uint32_t* B, int r, int N, uint32_t* V, uint32_t* XY) {
     memcpy(B, X, blockSize * sizeof(uint32_t));
 }
 
+static const scrypt_romix_fn romix = scrypt_romix;
+
+// Portable scrypt_romix_lanes_fn: the lanes one after another, each with
+// its own slice of V and XY
+static void scrypt_romix_lanes_portable(uint32_t* const B[SCRYPT_LANES], int r, int N,
+                                        uint32_t* V, uint32_t* XY) {
+    size_t blockWords = 32 * (size_t)r;
+    for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+        scrypt_romix(B[lane], r, N, 1, V + lane * N * blockWords, XY + lane * 2 * blockWords);
+    }
+}
+
+static const scrypt_romix_lanes_fn romix_lanes = scrypt_romix_lanes_portable;
+#endif
+
+// Scratch memory for one thread's hashes: V, XY and B for up to `lanes`
+// hashes in one anonymous mapping, each starting on its own cache line.
+// Kept until the parameters change so V stays resident between hashes.
+// With a TMTO factor above 1 the lanes run one after another and share a
+// single V. An arena is rebuilt when scrypt_set_tmto changes the setting it
+// was sized with.
+struct ScryptArena {
+    uint8_t* base = nullptr;
+    size_t size = 0;
+    int N = 0;
+    int r = 0;
+    int p = 0;
+    int lanes = 0;
+    int tmto = 1;
+    int tmtoSetting = 0;
+    uint32_t* V = nullptr;
+    uint32_t* XY = nullptr;
+    uint8_t* B = nullptr;
+    
+    ~ScryptArena();
+};
+
+#define SCRYPT_ARENA_ALIGN 64
+
+// Arenas this large start on a huge page boundary and are hinted for
+// transparent huge pages. At large N nearly every V[j] read would otherwise
+// miss the TLB.
+#define SCRYPT_HUGE_PAGE (2 * 1024 * 1024)
+
+// Largest TMTO factor picked automatically. Each doubling adds about half a
+// BlockMix per V lookup on average.
+#define SCRYPT_TMTO_AUTO_MAX 4
+
+static thread_local ScryptArena arena;
+
+// scrypt_set_tmto value, 0 for automatic
+static std::atomic<int> tmtoSetting(0);
+
+// Smallest power-of-two factor that fits one hash's V into half of this
+// core's share of L2, leaving the rest for B, XY and everything else. V that
+// won't fit at any factor (large N) is kept whole.
+static int tmto_for_cache(size_t vSize) {
+    size_t budget = cpu_l2_per_core() / 2;
+    if (budget == 0 || vSize / SCRYPT_TMTO_AUTO_MAX > budget) {
+        return 1;
+    }
+    int tmto = 1;
+    while (tmto < SCRYPT_TMTO_AUTO_MAX && vSize / tmto > budget) {
+        tmto *= 2;
+    }
+    return tmto;
+}
+
+static inline size_t arena_align(size_t size) {
+    return (size + SCRYPT_ARENA_ALIGN - 1) & ~(size_t)(SCRYPT_ARENA_ALIGN - 1);
+}
+
+// Page-aligned anonymous memory, huge-page aligned and hinted when large.
+// size must be a multiple of the page size.
+static uint8_t* arena_map(size_t size) {
+    if (size < SCRYPT_HUGE_PAGE) {
+        void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return mem == MAP_FAILED ? nullptr : (uint8_t*)mem;
+    }
+    
+    // Over-map by a huge page, then trim both ends to an aligned span
+    size_t span = size + SCRYPT_HUGE_PAGE;
+    void* mem = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        return nullptr;
+    }
+    uint8_t* raw = (uint8_t*)mem;
+    uint8_t* start = (uint8_t*)(((uintptr_t)raw + SCRYPT_HUGE_PAGE - 1) & ~(uintptr_t)(SCRYPT_HUGE_PAGE - 1));
+    size_t head = start - raw;
+    size_t tail = span - head - size;
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    if (tail > 0) {
+        munmap(start + size, tail);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(start, size, MADV_HUGEPAGE);
+#endif
+    return start;
+}
+
+// Page-rounded arena bytes for a TMTO factor, false if they overflow size_t
+static bool arena_layout(size_t blockSize, int N, int p, int lanes, int tmto, size_t pageSize,
+                         size_t* vSize, size_t* xySize, size_t* total) {
+    size_t vBlocks = tmto > 1 ? (size_t)(N + tmto - 1) / tmto : (size_t)N * lanes;
+    size_t vBytes;
+    size_t bBytes;
+    if (__builtin_mul_overflow(blockSize, vBlocks, &vBytes) ||
+        __builtin_mul_overflow(blockSize * lanes, (size_t)p, &bBytes) ||
+        vBytes > SIZE_MAX / 4 || bBytes > SIZE_MAX / 4) {
+        return false;
+    }
+    *vSize = arena_align(vBytes);
+    *xySize = arena_align(blockSize * 4 * lanes);
+    *total = (*vSize + *xySize + arena_align(bBytes) + pageSize - 1) & ~(pageSize - 1);
+    return true;
+}
+
+static void arena_release(ScryptArena* a) {
+    if (a->base) {
+        munmap(a->base, a->size);
+        a->base = nullptr;
+    }
+}
+
+ScryptArena::~ScryptArena() {
+    arena_release(this);
+}
+
+// RFC 7914: N a power of two above 1 and r * p below 2^30. r also bounds
+// XY's size in 32-bit size_t.
+static bool params_valid(int N, int r, int p) {
+    return N >= 2 && (N & (N - 1)) == 0 && r >= 1 && p >= 1 &&
+           (uint64_t)r * (uint64_t)p < (1u << 30) &&
+           (size_t)r <= SIZE_MAX / (128 * 4 * SCRYPT_LANES);
+}
+
+static bool arena_reserve(ScryptArena* a, int N, int r, int p, int lanes) {
+    int setting = tmtoSetting.load(std::memory_order_relaxed);
+    if (a->base && a->N == N && a->r == r && a->p == p && a->lanes >= lanes &&
+        a->tmtoSetting == setting) {
+        return true;
+    }
+    
+    arena_release(a);
+    if (!params_valid(N, r, p)) {
+        return false;
+    }
+    
+    size_t blockSize = 128 * (size_t)r;
+    // The automatic factor only applies to single hashes: above 1 the lanes
+    // would lose their interleaved ROMix, which costs more than the cache
+    // footprint saves
+    int tmto = setting > 0 ? setting : lanes > 1 ? 1 : tmto_for_cache(blockSize * (size_t)N);
+    if (tmto > N) {
+        tmto = N;
+    }
+    
+    // Out of memory (or address space on 32-bit ABIs): trade V for
+    // recomputation until it fits
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t vSize, xySize, total;
+    uint8_t* mem = nullptr;
+    for (;;) {
+        if (arena_layout(blockSize, N, p, lanes, tmto, pageSize, &vSize, &xySize, &total)) {
+            mem = arena_map(total);
+            if (mem) {
+                break;
+            }
+        }
+        if (tmto >= N) {
+            return false;
+        }
+        tmto = tmto > N / 2 ? N : tmto * 2;
+    }
+    
+    a->base = mem;
+    a->size = total;
+    a->V = (uint32_t*)a->base;
+    a->XY = (uint32_t*)(a->base + vSize);
+    a->B = a->base + vSize + xySize;
+    a->N = N;
+    a->r = r;
+    a->p = p;
+    a->lanes = lanes;
+    a->tmto = tmto;
+    a->tmtoSetting = setting;
+    return true;
+}
+
+void scrypt_release_scratch() {
+    arena_release(&arena);
+}
+
+void scrypt_set_tmto(int factor) {
+    tmtoSetting.store(factor > 0 ? factor : 0, std::memory_order_relaxed);
+}
+
+// Scrypt with the password's HMAC context shared by both PBKDF2 passes.
+// Returns false, with an all-zero output, if the arena can't be allocated.
+static bool scrypt_keyed(const HmacSha256Ctx* keyed, const uint8_t* salt, size_t saltLen,
+                         int N, int r, int p, uint8_t* output, size_t outputLen) {
+    size_t blockSize = 128 * (size_t)r;
+    
+    if (!arena_reserve(&arena, N, r, p, 1)) {
+        memset(output, 0, outputLen);
+        return false;
+    }
+    uint8_t* B = arena.B;
+    
+    // Derive initial key using PBKDF2
+    pbkdf2_sha256(keyed, salt, saltLen, 1, B, blockSize * p);
+    
+    // Apply ROMix to each block
+    for (int i = 0; i < p; i++) {
+        romix((uint32_t*)(B + i * blockSize), r, N, arena.tmto, arena.V, arena.XY);
+    }
+    
+    // Derive output using PBKDF2
+    pbkdf2_sha256(keyed, B, blockSize * p, 1, output, outputLen);
+    return true;
+}
+
+// scrypt_keyed for SCRYPT_LANES hashes with ROMix in lockstep
+static bool scrypt_keyed_lanes(const HmacSha256Ctx keyed[SCRYPT_LANES],
+                               const uint8_t* const salts[SCRYPT_LANES], size_t saltLen,
+                               int N, int r, int p,
+                               uint8_t* const outputs[SCRYPT_LANES], size_t outputLen) {
+    size_t blockSize = 128 * (size_t)r;
+    
+    if (!arena_reserve(&arena, N, r, p, SCRYPT_LANES)) {
+        for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+            memset(outputs[lane], 0, outputLen);
+        }
+        return false;
+    }
+    
+    // Each lane's p blocks are contiguous, as in scrypt_keyed
+    uint8_t* B[SCRYPT_LANES];
+    for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+        B[lane] = arena.B + lane * blockSize * p;
+        pbkdf2_sha256(&keyed[lane], salts[lane], saltLen, 1, B[lane], blockSize * p);
+    }
+    
+    for (int i = 0; i < p; i++) {
+        uint32_t* blocks[SCRYPT_LANES];
+        for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+            blocks[lane] = (uint32_t*)(B[lane] + i * blockSize);
+        }
+        if (arena.tmto > 1) {
+            for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+                romix(blocks[lane], r, N, arena.tmto, arena.V, arena.XY);
+            }
+        } else {
+            romix_lanes(blocks, r, N, arena.V, arena.XY);
+        }
+    }
+    
+    for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+        pbkdf2_sha256(&keyed[lane], B[lane], blockSize * p, 1, outputs[lane], outputLen);
+    }
+    return true;
+}
+
 void scrypt_hash(const uint8_t* password, size_t passwordLen,
                  const uint8_t* salt, size_t saltLen,
                  int N, int r, int p,
                  uint8_t* output, size_t outputLen) {
+    HmacSha256Ctx keyed;
+    hmac_sha256_init(&keyed, password, passwordLen);
+    scrypt_keyed(&keyed, salt, saltLen, N, r, p, output, outputLen);
+}
+
+// ROMix on blocks first..last-1 of B with the calling thread's arena.
+// Returns false through ok if the arena can't be allocated.
+static void romix_range(uint8_t* B, int first, int last, int N, int r, bool* ok) {
+    size_t blockSize = 128 * (size_t)r;
+    *ok = arena_reserve(&arena, N, r, 1, 1);
+    for (int i = first; i < last && *ok; i++) {
+        romix((uint32_t*)(B + i * blockSize), r, N, arena.tmto, arena.V, arena.XY);
+    }
+}
+
+void scrypt_hash_parallel(const uint8_t* password, size_t passwordLen,
+                          const uint8_t* salt, size_t saltLen,
+                          int N, int r, int p,
+                          uint8_t* output, size_t outputLen, int threads) {
+    if (!params_valid(N, r, p)) {
+        memset(output, 0, outputLen);
+        return;
+    }
     
-    // For Litecoin: N=1024, r=1, p=1
-    int blockSize = 128 * r;
+    // Workers that can't be started leave fewer, larger shares
+    threads = thread_pool_threads(threads, p);
+    if (threads <= 1) {
+        scrypt_hash(password, passwordLen, salt, saltLen, N, r, p, output, outputLen);
+        return;
+    }
     
-    // Derive initial key using PBKDF2
-    uint8_t* B = (uint8_t*)malloc(blockSize * p);
-    pbkdf2_sha256(password, passwordLen, salt, saltLen, 1, B, blockSize * p);
+    HmacSha256Ctx keyed;
+    hmac_sha256_init(&keyed, password, passwordLen);
     
-    // Allocate memory for ROMix
-    uint32_t* V = (uint32_t*)malloc(blockSize * N);
-    uint32_t* XY = (uint32_t*)malloc(blockSize * 2);
+    // B is shared by all threads, so it lives outside the per-thread arenas.
+    // Like the arenas, a B that overflows size_t or can't be allocated
+    // gives the all-zero output rather than a crash.
+    size_t blockSize = 128 * (size_t)r;
+    size_t bSize;
+    std::unique_ptr<uint8_t[]> B;
+    if (!__builtin_mul_overflow(blockSize, (size_t)p, &bSize)) {
+        B.reset(new (std::nothrow) uint8_t[bSize]);
+    }
+    if (!B) {
+        memset(output, 0, outputLen);
+        return;
+    }
+    pbkdf2_sha256(&keyed, salt, saltLen, 1, B.get(), bSize);
     
-    // Apply ROMix to each block
-    for (int i = 0; i < p; i++) {
-        scrypt_romix((uint32_t*)(B + i * blockSize), r, N, V, XY);
+    // Blocks are dealt out evenly and the calling thread takes the last share
+    std::unique_ptr<bool[]> ok(new bool[threads]());
+    uint8_t* blocks = B.get();
+    thread_pool_run(threads, [=, &ok](int t) {
+        int first = (int)((int64_t)p * t / threads);
+        int last = (int)((int64_t)p * (t + 1) / threads);
+        romix_range(blocks, first, last, N, r, &ok[t]);
+    });
+    
+    for (int t = 0; t < threads; t++) {
+        if (!ok[t]) {
+            memset(output, 0, outputLen);
+            return;
+        }
     }
+    pbkdf2_sha256(&keyed, B.get(), bSize, 1, output, outputLen);
+}
+
+void scrypt_hash_lanes(const uint8_t* const passwords[SCRYPT_LANES], size_t passwordLen,
+                       const uint8_t* const salts[SCRYPT_LANES], size_t saltLen,
+                       int N, int r, int p,
+                       uint8_t* const outputs[SCRYPT_LANES], size_t outputLen) {
+    HmacSha256Ctx keyed[SCRYPT_LANES];
+    for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+        hmac_sha256_init(&keyed[lane], passwords[lane], passwordLen);
+    }
+    scrypt_keyed_lanes(keyed, salts, saltLen, N, r, p, outputs, outputLen);
+}
+
+void scrypt_mine_init(ScryptMineCtx* ctx, const uint8_t header[SCRYPT_HEADER_LEN],
+                      int N, int r, int p) {
+    memcpy(ctx->header, header, SCRYPT_HEADER_LEN);
+    sha256_init(&ctx->keyPrefix);
+    sha256_update(&ctx->keyPrefix, header, 64);
+    ctx->N = N;
+    ctx->r = r;
+    ctx->p = p;
+}
+
+// Header with the nonce in place, and its HMAC context. The header is longer
+// than a SHA-256 block, so the HMAC key is its hash, resumed from the prefix.
+static void mine_keyed(const ScryptMineCtx* ctx, uint32_t nonce,
+                       uint8_t header[SCRYPT_HEADER_LEN], HmacSha256Ctx* keyed) {
+    uint8_t key[32];
+    Sha256Ctx sha;
     
-    // Derive output using PBKDF2
-    pbkdf2_sha256(password, passwordLen, B, blockSize * p, 1, output, outputLen);
+    memcpy(header, ctx->header, SCRYPT_HEADER_LEN);
+    header[76] = (uint8_t)nonce;
+    header[77] = (uint8_t)(nonce >> 8);
+    header[78] = (uint8_t)(nonce >> 16);
+    header[79] = (uint8_t)(nonce >> 24);
     
-    free(B);
-    free(V);
-    free(XY);
+    sha256_clone(&sha, &ctx->keyPrefix);
+    sha256_update(&sha, header + 64, SCRYPT_HEADER_LEN - 64);
+    sha256_final(&sha, key);
+    hmac_sha256_init(keyed, key, 32);
+}
+
+bool scrypt_mine_hash(const ScryptMineCtx* ctx, uint32_t nonce, uint8_t hash[32]) {
+    uint8_t header[SCRYPT_HEADER_LEN];
+    HmacSha256Ctx keyed;
+    mine_keyed(ctx, nonce, header, &keyed);
+    return scrypt_keyed(&keyed, header, SCRYPT_HEADER_LEN, ctx->N, ctx->r, ctx->p, hash, 32);
+}
+
+bool scrypt_mine_hash_lanes(const ScryptMineCtx* ctx, uint32_t nonce,
+                            uint8_t hashes[SCRYPT_LANES][32]) {
+    uint8_t headers[SCRYPT_LANES][SCRYPT_HEADER_LEN];
+    HmacSha256Ctx keyed[SCRYPT_LANES];
+    const uint8_t* salts[SCRYPT_LANES];
+    uint8_t* outputs[SCRYPT_LANES];
+    for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+        mine_keyed(ctx, nonce + lane, headers[lane], &keyed[lane]);
+        salts[lane] = headers[lane];
+        outputs[lane] = hashes[lane];
+    }
+    return scrypt_keyed_lanes(keyed, salts, SCRYPT_HEADER_LEN, ctx->N, ctx->r, ctx->p, outputs, 32);
+}
+
+// Little-endian 256-bit compare, byte 31 most significant
+static inline bool below_target(const uint8_t hash[32], const uint8_t target[32]) {
+    for (int i = 31; i >= 0; i--) {
+        if (hash[i] != target[i]) {
+            return hash[i] < target[i];
+        }
+    }
+    return false;
+}
+
+bool scrypt_mine_scan(const ScryptMineCtx* ctx, uint32_t first, uint32_t last,
+                      const uint8_t target[32], uint32_t* found, uint64_t* hashes) {
+    uint8_t lanes[SCRYPT_LANES][32];
+    uint8_t hash[32];
+    *hashes = 0;
+    if (first > last) {
+        return false;
+    }
+    
+    // 64-bit cursor so a range ending at 0xFFFFFFFF terminates. Without
+    // scratch memory the hashes are all zero, which would pass any target,
+    // so the scan stops there.
+    uint64_t nonce = first;
+    while (last - nonce + 1 >= SCRYPT_LANES) {
+        if (!scrypt_mine_hash_lanes(ctx, (uint32_t)nonce, lanes)) {
+            return false;
+        }
+        *hashes += SCRYPT_LANES;
+        for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+            if (below_target(lanes[lane], target)) {
+                *found = (uint32_t)nonce + lane;
+                return true;
+            }
+        }
+        nonce += SCRYPT_LANES;
+    }
+    
+    for (; nonce <= last; nonce++) {
+        if (!scrypt_mine_hash(ctx, (uint32_t)nonce, hash)) {
+            return false;
+        }
+        (*hashes)++;
+        if (below_target(hash, target)) {
+            *found = (uint32_t)nonce;
+            return true;
+        }
+    }
+    return false;
 }
@@ -3,11 +3,86 @@
 
 #include <cstdint>
 #include <cstddef>
+#include "sha256.h"
 
-// Scrypt hash function (memory-hard, used by Litecoin)
+// Scrypt hash function (memory-hard, used by Litecoin). Scratch memory is
+// kept per thread and reused while N, r and p stay the same.
+// Parameters outside RFC 7914 (N not a power of two above 1, r or p below
+// 1, r * p of 2^30 or more) or scratch that can't be allocated give an
+// all-zero output.
 void scrypt_hash(const uint8_t* password, size_t passwordLen,
                  const uint8_t* salt, size_t saltLen,
                  int N, int r, int p,
                  uint8_t* output, size_t outputLen);
 
+// scrypt_hash with its p ROMix blocks split between the calling thread and
+// the shared thread pool's workers, each with its own scratch memory. Uses
+// up to `threads` threads (0 for one per CPU), capped as thread_pool_threads
+// does and at p.
+// Same output as scrypt_hash; p = 1 runs on the calling thread.
+void scrypt_hash_parallel(const uint8_t* password, size_t passwordLen,
+                          const uint8_t* salt, size_t saltLen,
+                          int N, int r, int p,
+                          uint8_t* output, size_t outputLen, int threads);
+
+// Hashes computed together by scrypt_hash_lanes
+#define SCRYPT_LANES 4
+
+// Scrypt of SCRYPT_LANES independent password/salt pairs (e.g. one header
+// per nonce). Their ROMix runs in lockstep with Salsa20/8 vectorized across
+// the hashes, overlapping the random reads of V. Same output as calling
+// scrypt_hash on each pair.
+void scrypt_hash_lanes(const uint8_t* const passwords[SCRYPT_LANES], size_t passwordLen,
+                       const uint8_t* const salts[SCRYPT_LANES], size_t saltLen,
+                       int N, int r, int p,
+                       uint8_t* const outputs[SCRYPT_LANES], size_t outputLen);
+
+// Litecoin-style scrypt mining: the 80-byte block header is both password
+// and salt, with the nonce little-endian in its last 4 bytes
+#define SCRYPT_HEADER_LEN 80
+
+// Per-job state. The HMAC key is SHA256(header), so the first 64 header
+// bytes are absorbed once here and each nonce only hashes the last 16.
+struct ScryptMineCtx {
+    uint8_t header[SCRYPT_HEADER_LEN];
+    Sha256Ctx keyPrefix;
+    int N;
+    int r;
+    int p;
+};
+
+void scrypt_mine_init(ScryptMineCtx* ctx, const uint8_t header[SCRYPT_HEADER_LEN],
+                      int N, int r, int p);
+
+// 32-byte scrypt of the header with the given nonce. Returns false, with an
+// all-zero hash, if scratch memory can't be allocated.
+bool scrypt_mine_hash(const ScryptMineCtx* ctx, uint32_t nonce, uint8_t hash[32]);
+
+// Hashes for nonces nonce .. nonce + SCRYPT_LANES - 1, as scrypt_hash_lanes.
+// Returns false as scrypt_mine_hash does.
+bool scrypt_mine_hash_lanes(const ScryptMineCtx* ctx, uint32_t nonce,
+                            uint8_t hashes[SCRYPT_LANES][32]);
+
+// Hash nonces first..last (inclusive) and stop at the first hash below
+// target (both read as little-endian 256-bit numbers), SCRYPT_LANES nonces
+// at a time. Returns true with *found set on success; *hashes receives the
+// number of nonces hashed either way. Stops with false if scratch memory
+// can't be allocated.
+bool scrypt_mine_scan(const ScryptMineCtx* ctx, uint32_t first, uint32_t last,
+                      const uint8_t target[32], uint32_t* found, uint64_t* hashes);
+
+// Time-memory tradeoff for all threads: keep every factor-th block of V
+// and recompute the others when read, shrinking V to 1/factor for about
+// (factor - 1) / 2 extra BlockMix per lookup. Hashes are unchanged. Each
+// thread picks the setting up on its next hash. 1 keeps all of V. 0, the
+// default, picks a factor for single hashes from the L2 cache of the core
+// the thread is on when its scratch memory is allocated, and keeps all of V
+// for scrypt_hash_lanes. An explicit factor above 1 makes scrypt_hash_lanes
+// hash its lanes one at a time.
+void scrypt_set_tmto(int factor);
+
+// Free the calling thread's scratch memory, e.g. when the system asks to
+// trim memory. The next hash on this thread allocates it again.
+void scrypt_release_scratch();
+
 #endif // SCRYPT_H
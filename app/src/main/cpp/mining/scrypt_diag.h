@@ -0,0 +1,180 @@
+#ifndef SCRYPT_DIAG_H
+#define SCRYPT_DIAG_H
+
+#include "scrypt_impl.h"
+
+// Single-stream scrypt ROMix with each 64-byte Salsa20/8 block held in four
+// 128-bit vectors along the state's diagonals:
+//   (x0, x5, x10, x15) (x12, x1, x6, x11) (x8, x13, x2, x7) (x4, x9, x14, x3)
+// In this layout every quarter-round step works on whole vectors, and only
+// lane rotations are needed between the column and row halves. B, V and
+// X all stay permuted; words are reordered on entry and exit only.
+//
+// V provides the vector type and operations:
+//   T, add, xor_, rotl<n>, load(const uint32_t*), store(uint32_t*, T),
+//   shuffle<n>(x) (lane i of the result is lane (i + n) % 4 of x)
+// Include this only from a translation unit compiled for V's instruction set.
+//
+// R, NC and TMTO fix r, N and the TMTO factor at compile time, or are 0 to
+// use the runtime arguments. Fixed, the BlockMix loops unroll and % N and
+// / tmto become masks and shifts.
+
+namespace scrypt_diag {
+
+// Word of the standard layout held at each position of the diagonal layout
+static const int DIAG_ORDER[16] = {
+    0, 5, 10, 15, 12, 1, 6, 11, 8, 13, 2, 7, 4, 9, 14, 3
+};
+
+template <typename V, int n>
+static inline typename V::T step(typename V::T a, typename V::T b, typename V::T c) {
+    return V::xor_(a, V::template rotl<n>(V::add(b, c)));
+}
+
+// Salsa20/8 core on one diagonal-layout block
+template <typename V>
+static inline void salsa20_8(typename V::T B[4]) {
+    typename V::T x0 = B[0];
+    typename V::T x1 = B[1];
+    typename V::T x2 = B[2];
+    typename V::T x3 = B[3];
+    
+    for (int i = 0; i < 8; i += 2) {
+        // Columns
+        x3 = step<V,  7>(x3, x0, x1);
+        x2 = step<V,  9>(x2, x3, x0);
+        x1 = step<V, 13>(x1, x2, x3);
+        x0 = step<V, 18>(x0, x1, x2);
+        
+        // Rows line up after rotating the lanes
+        x1 = V::template shuffle<1>(x1);
+        x2 = V::template shuffle<2>(x2);
+        x3 = V::template shuffle<3>(x3);
+        x1 = step<V,  7>(x1, x0, x3);
+        x2 = step<V,  9>(x2, x1, x0);
+        x3 = step<V, 13>(x3, x2, x1);
+        x0 = step<V, 18>(x0, x3, x2);
+        x1 = V::template shuffle<3>(x1);
+        x2 = V::template shuffle<2>(x2);
+        x3 = V::template shuffle<1>(x3);
+    }
+    
+    B[0] = V::add(B[0], x0);
+    B[1] = V::add(B[1], x1);
+    B[2] = V::add(B[2], x2);
+    B[3] = V::add(B[3], x3);
+}
+
+// BlockMix of in (XORed with other when MIX) into out, writing even blocks
+// to the first half and odd blocks to the second, so no rearranging copy
+template <typename V, bool MIX, int R>
+static inline void block_mix(const uint32_t* in, const uint32_t* other, uint32_t* out, int r) {
+    if (R) {
+        r = R;
+    }
+    typename V::T X[4];
+    const int last = (2 * r - 1) * 16;
+    for (int k = 0; k < 4; k++) {
+        X[k] = V::load(in + last + k * 4);
+        if (MIX) {
+            X[k] = V::xor_(X[k], V::load(other + last + k * 4));
+        }
+    }
+    
+    for (int i = 0; i < 2 * r; i++) {
+        const int offset = i * 16;
+        for (int k = 0; k < 4; k++) {
+            X[k] = V::xor_(X[k], V::load(in + offset + k * 4));
+            if (MIX) {
+                X[k] = V::xor_(X[k], V::load(other + offset + k * 4));
+            }
+        }
+        salsa20_8<V>(X);
+        uint32_t* dst = out + ((i & 1) ? r + i / 2 : i / 2) * 16;
+        for (int k = 0; k < 4; k++) {
+            V::store(dst + k * 4, X[k]);
+        }
+    }
+}
+
+template <typename V, int R, int NC, int TMTO>
+static inline void romix(uint32_t* B, int r, int N, int tmto, uint32_t* table, uint32_t* XY) {
+    if (R) {
+        r = R;
+    }
+    if (NC) {
+        N = NC;
+    }
+    if (TMTO) {
+        tmto = TMTO;
+    }
+    const int words = 32 * r;
+    uint32_t* X = XY;
+    uint32_t* Y = XY + words;
+    uint32_t* T0 = XY + 2 * words;
+    uint32_t* T1 = XY + 3 * words;
+    
+    for (int i = 0; i < words; i += 16) {
+        for (int k = 0; k < 16; k++) {
+            table[i + k] = B[i + DIAG_ORDER[k]];
+        }
+    }
+    
+    // Step 1: BlockMix writes straight into the next kept V slot, and
+    // ping-pongs through X and Y for the blocks in between
+    const uint32_t* cur = table;
+    for (int i = 1; i < N; i++) {
+        uint32_t* dst = i % tmto == 0 ? table + (size_t)(i / tmto) * words : (cur == X ? Y : X);
+        block_mix<V, false, R>(cur, nullptr, dst, r);
+        cur = dst;
+    }
+    if (cur == X) {
+        X = Y;
+        Y = XY;
+    }
+    block_mix<V, false, R>(cur, nullptr, X, r);
+    
+    // Step 2: X ^ V[j] is formed while loading BlockMix input. Word 0 of a
+    // block is x0 in either layout.
+    for (int i = 0; i < N; i++) {
+        uint32_t j = X[(2 * r - 1) * 16] % (uint32_t)N;
+        const uint32_t* v = table + (size_t)(j / tmto) * words;
+        scrypt_prefetch_block(v, r);
+        for (uint32_t m = j % tmto; m > 0; m--) {
+            uint32_t* dst = v == T0 ? T1 : T0;
+            block_mix<V, false, R>(v, nullptr, dst, r);
+            v = dst;
+        }
+        block_mix<V, true, R>(X, v, Y, r);
+        uint32_t* t = X;
+        X = Y;
+        Y = t;
+    }
+    
+    for (int i = 0; i < words; i += 16) {
+        for (int k = 0; k < 16; k++) {
+            B[i + DIAG_ORDER[k]] = X[i + k];
+        }
+    }
+}
+
+// scrypt_romix_fn: Litecoin's (1024, 1) with and without TMTO and the
+// common KDF setting (16384, 8) get their own kernels
+template <typename V>
+static inline void romix_any(uint32_t* B, int r, int N, int tmto, uint32_t* table, uint32_t* XY) {
+    if (r == 1 && N == 1024) {
+        if (tmto == 1) {
+            romix<V, 1, 1024, 1>(B, r, N, tmto, table, XY);
+        } else {
+            romix<V, 1, 1024, 0>(B, r, N, tmto, table, XY);
+        }
+    } else if (r == 8 && N == 16384 && tmto == 1) {
+        romix<V, 8, 16384, 1>(B, r, N, tmto, table, XY);
+    } else {
+        romix<V, 0, 0, 0>(B, r, N, tmto, table, XY);
+    }
+}
+
+} // namespace scrypt_diag
+
+#endif // SCRYPT_DIAG_H
@@ -0,0 +1,44 @@
+#ifndef SCRYPT_IMPL_H
+#define SCRYPT_IMPL_H
+
+// Internal interface between scrypt.cpp and the SIMD kernels
+
+#include <cstdint>
+#include <cstddef>
+#include "scrypt.h"
+
+// ROMix on one 128*r byte block, keeping every tmto-th block of the table
+// and recomputing the rest when read. V holds ceil(N / tmto) blocks and XY
+// 4 blocks.
+typedef void (*scrypt_romix_fn)(uint32_t* B, int r, int N, int tmto, uint32_t* V, uint32_t* XY);
+
+// ROMix on SCRYPT_LANES independent 128*r byte blocks in lockstep. V holds
+// N blocks per lane and XY 2 blocks per lane.
+typedef void (*scrypt_romix_lanes_fn)(uint32_t* const B[SCRYPT_LANES], int r, int N,
+                                      uint32_t* V, uint32_t* XY);
+
+// Start loading a 128*r byte block of V as soon as its index is known, so
+// all of its cache lines are in flight together
+static inline void scrypt_prefetch_block(const uint32_t* block, int r) {
+    for (int k = 0; k < 32 * r; k += 16) {
+        __builtin_prefetch(block + k);
+    }
+}
+
+// NEON is baseline on arm64 and enabled with -mfpu=neon on armeabi-v7a
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SCRYPT_HAVE_NEON 1
+void scrypt_romix_neon(uint32_t* B, int r, int N, int tmto, uint32_t* V, uint32_t* XY);
+void scrypt_romix_lanes_neon(uint32_t* const B[SCRYPT_LANES], int r, int N,
+                             uint32_t* V, uint32_t* XY);
+#endif
+
+// SSE2 is baseline on x86_64
+#if defined(__x86_64__) && defined(__SSE2__)
+#define SCRYPT_HAVE_SSE2 1
+void scrypt_romix_sse2(uint32_t* B, int r, int N, int tmto, uint32_t* V, uint32_t* XY);
+void scrypt_romix_lanes_sse2(uint32_t* const B[SCRYPT_LANES], int r, int N,
+                             uint32_t* V, uint32_t* XY);
+#endif
+
+#endif // SCRYPT_IMPL_H
@@ -0,0 +1,203 @@
+#ifndef SCRYPT_LANES_H
+#define SCRYPT_LANES_H
+
+#include "scrypt_impl.h"
+#include <cstring>
+
+// Lane-interleaved scrypt ROMix for 128-bit vectors. The working blocks X
+// and Y are stored interleaved, so word k of all four lanes is one vector
+// at X + 4 * k; each lane keeps its own contiguous V so the random reads
+// of step 2 stay one block per lane.
+//
+// V provides the vector type and operations:
+//   T, add, xor_, rotl<n>, load(const uint32_t*), store(uint32_t*, T),
+//   transpose(T&, T&, T&, T&) (4x4 transpose of 32-bit words)
+// Include this only from a translation unit compiled for V's instruction set.
+//
+// R and NC fix r and N at compile time, or are 0 to use the runtime
+// arguments, as in scrypt_diag.h.
+
+namespace scrypt_lanes {
+
+template <typename V, int n>
+static inline typename V::T step(typename V::T a, typename V::T b, typename V::T c) {
+    return V::xor_(a, V::template rotl<n>(V::add(b, c)));
+}
+
+// Salsa20/8 core on word vectors B[0..15]
+template <typename V>
+static inline void salsa20_8(typename V::T B[16]) {
+    typename V::T x[16];
+    for (int i = 0; i < 16; i++) {
+        x[i] = B[i];
+    }
+    
+    for (int i = 0; i < 8; i += 2) {
+        // Columns
+        x[ 4] = step<V,  7>(x[ 4], x[ 0], x[12]);
+        x[ 8] = step<V,  9>(x[ 8], x[ 4], x[ 0]);
+        x[12] = step<V, 13>(x[12], x[ 8], x[ 4]);
+        x[ 0] = step<V, 18>(x[ 0], x[12], x[ 8]);
+        
+        x[ 9] = step<V,  7>(x[ 9], x[ 5], x[ 1]);
+        x[13] = step<V,  9>(x[13], x[ 9], x[ 5]);
+        x[ 1] = step<V, 13>(x[ 1], x[13], x[ 9]);
+        x[ 5] = step<V, 18>(x[ 5], x[ 1], x[13]);
+        
+        x[14] = step<V,  7>(x[14], x[10], x[ 6]);
+        x[ 2] = step<V,  9>(x[ 2], x[14], x[10]);
+        x[ 6] = step<V, 13>(x[ 6], x[ 2], x[14]);
+        x[10] = step<V, 18>(x[10], x[ 6], x[ 2]);
+        
+        x[ 3] = step<V,  7>(x[ 3], x[15], x[11]);
+        x[ 7] = step<V,  9>(x[ 7], x[ 3], x[15]);
+        x[11] = step<V, 13>(x[11], x[ 7], x[ 3]);
+        x[15] = step<V, 18>(x[15], x[11], x[ 7]);
+        
+        // Rows
+        x[ 1] = step<V,  7>(x[ 1], x[ 0], x[ 3]);
+        x[ 2] = step<V,  9>(x[ 2], x[ 1], x[ 0]);
+        x[ 3] = step<V, 13>(x[ 3], x[ 2], x[ 1]);
+        x[ 0] = step<V, 18>(x[ 0], x[ 3], x[ 2]);
+        
+        x[ 6] = step<V,  7>(x[ 6], x[ 5], x[ 4]);
+        x[ 7] = step<V,  9>(x[ 7], x[ 6], x[ 5]);
+        x[ 4] = step<V, 13>(x[ 4], x[ 7], x[ 6]);
+        x[ 5] = step<V, 18>(x[ 5], x[ 4], x[ 7]);
+        
+        x[11] = step<V,  7>(x[11], x[10], x[ 9]);
+        x[ 8] = step<V,  9>(x[ 8], x[11], x[10]);
+        x[ 9] = step<V, 13>(x[ 9], x[ 8], x[11]);
+        x[10] = step<V, 18>(x[10], x[ 9], x[ 8]);
+        
+        x[12] = step<V,  7>(x[12], x[15], x[14]);
+        x[13] = step<V,  9>(x[13], x[12], x[15]);
+        x[14] = step<V, 13>(x[14], x[13], x[12]);
+        x[15] = step<V, 18>(x[15], x[14], x[13]);
+    }
+    
+    for (int i = 0; i < 16; i++) {
+        B[i] = V::add(B[i], x[i]);
+    }
+}
+
+// BlockMix on interleaved blocks
+template <typename V, int R>
+static inline void block_mix(uint32_t* B, uint32_t* Y, int r) {
+    if (R) {
+        r = R;
+    }
+    typename V::T X[16];
+    const uint32_t* last = B + (2 * r - 1) * 16 * SCRYPT_LANES;
+    for (int k = 0; k < 16; k++) {
+        X[k] = V::load(last + k * SCRYPT_LANES);
+    }
+    
+    for (int i = 0; i < 2 * r; i++) {
+        const uint32_t* in = B + i * 16 * SCRYPT_LANES;
+        for (int k = 0; k < 16; k++) {
+            X[k] = V::xor_(X[k], V::load(in + k * SCRYPT_LANES));
+        }
+        salsa20_8<V>(X);
+        uint32_t* out = Y + i * 16 * SCRYPT_LANES;
+        for (int k = 0; k < 16; k++) {
+            V::store(out + k * SCRYPT_LANES, X[k]);
+        }
+    }
+    
+    // Rearrange: even blocks, then odd blocks
+    const size_t blockBytes = 16 * SCRYPT_LANES * sizeof(uint32_t);
+    for (int i = 0; i < r; i++) {
+        memcpy(B + i * 16 * SCRYPT_LANES, Y + (2 * i) * 16 * SCRYPT_LANES, blockBytes);
+        memcpy(B + (r + i) * 16 * SCRYPT_LANES, Y + (2 * i + 1) * 16 * SCRYPT_LANES, blockBytes);
+    }
+}
+
+// Lanes' V are held in table one after another
+template <typename V, int R, int NC>
+static inline void romix(uint32_t* const B[SCRYPT_LANES], int r, int N,
+                         uint32_t* table, uint32_t* XY) {
+    if (R) {
+        r = R;
+    }
+    if (NC) {
+        N = NC;
+    }
+    typedef typename V::T T;
+    const int words = 32 * r;
+    const size_t laneStride = (size_t)N * words;
+    uint32_t* X = XY;
+    uint32_t* Y = XY + words * SCRYPT_LANES;
+    
+    for (int k = 0; k < words; k++) {
+        for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+            X[k * SCRYPT_LANES + lane] = B[lane][k];
+        }
+    }
+    
+    // Step 1: fill each lane's V with its copies of X, transposing four
+    // words of every lane at a time
+    for (int i = 0; i < N; i++) {
+        uint32_t* dst = table + (size_t)i * words;
+        for (int k = 0; k < words; k += 4) {
+            T a = V::load(X + (k + 0) * SCRYPT_LANES);
+            T b = V::load(X + (k + 1) * SCRYPT_LANES);
+            T c = V::load(X + (k + 2) * SCRYPT_LANES);
+            T d = V::load(X + (k + 3) * SCRYPT_LANES);
+            V::transpose(a, b, c, d);
+            V::store(dst + k, a);
+            V::store(dst + laneStride + k, b);
+            V::store(dst + 2 * laneStride + k, c);
+            V::store(dst + 3 * laneStride + k, d);
+        }
+        block_mix<V, R>(X, Y, r);
+    }
+    
+    // Step 2: all lanes' random blocks are read together, so their cache
+    // misses overlap instead of forming one serial chain
+    const uint32_t* last = X + (2 * r - 1) * 16 * SCRYPT_LANES;
+    for (int i = 0; i < N; i++) {
+        const uint32_t* src[SCRYPT_LANES];
+        for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+            uint32_t j = last[lane] % (uint32_t)N;
+            src[lane] = table + lane * laneStride + (size_t)j * words;
+            scrypt_prefetch_block(src[lane], r);
+        }
+        for (int k = 0; k < words; k += 4) {
+            T a = V::load(src[0] + k);
+            T b = V::load(src[1] + k);
+            T c = V::load(src[2] + k);
+            T d = V::load(src[3] + k);
+            V::transpose(a, b, c, d);
+            uint32_t* x = X + k * SCRYPT_LANES;
+            V::store(x, V::xor_(V::load(x), a));
+            V::store(x + SCRYPT_LANES, V::xor_(V::load(x + SCRYPT_LANES), b));
+            V::store(x + 2 * SCRYPT_LANES, V::xor_(V::load(x + 2 * SCRYPT_LANES), c));
+            V::store(x + 3 * SCRYPT_LANES, V::xor_(V::load(x + 3 * SCRYPT_LANES), d));
+        }
+        block_mix<V, R>(X, Y, r);
+    }
+    
+    for (int k = 0; k < words; k++) {
+        for (int lane = 0; lane < SCRYPT_LANES; lane++) {
+            B[lane][k] = X[k * SCRYPT_LANES + lane];
+        }
+    }
+}
+
+// scrypt_romix_lanes_fn, with kernels for (1024, 1) and (16384, 8)
+template <typename V>
+static inline void romix_any(uint32_t* const B[SCRYPT_LANES], int r, int N,
+                             uint32_t* table, uint32_t* XY) {
+    if (r == 1 && N == 1024) {
+        romix<V, 1, 1024>(B, r, N, table, XY);
+    } else if (r == 8 && N == 16384) {
+        romix<V, 8, 16384>(B, r, N, table, XY);
+    } else {
+        romix<V, 0, 0>(B, r, N, table, XY);
+    }
+}
+
+} // namespace scrypt_lanes
+
+#endif // SCRYPT_LANES_H
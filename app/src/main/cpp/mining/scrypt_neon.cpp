@@ -0,0 +1,50 @@
+/**
+ * NEON scrypt: diagonal-layout single-stream ROMix, and four hashes
+ * through ROMix in lockstep, one per 32-bit lane. Used on armeabi-v7a and arm64.
+ */
+
+#include "scrypt_impl.h"
+
+#if SCRYPT_HAVE_NEON
+
+#include "scrypt_lanes.h"
+#include "scrypt_diag.h"
+#include <arm_neon.h>
+
+namespace {
+
+// 4 x 32-bit lanes for scrypt_lanes and scrypt_diag
+struct Neon {
+    typedef uint32x4_t T;
+    
+    static inline T add(T a, T b) { return vaddq_u32(a, b); }
+    static inline T xor_(T a, T b) { return veorq_u32(a, b); }
+    // Shift-left-and-insert saves the OR of a shift pair
+    template <int n> static inline T rotl(T x) { return vsliq_n_u32(vshrq_n_u32(x, 32 - n), x, n); }
+    static inline T load(const uint32_t* p) { return vld1q_u32(p); }
+    static inline void store(uint32_t* p, T x) { vst1q_u32(p, x); }
+    
+    template <int n> static inline T shuffle(T x) { return vextq_u32(x, x, n); }
+    
+    static inline void transpose(T& a, T& b, T& c, T& d) {
+        uint32x4x2_t ab = vtrnq_u32(a, b);
+        uint32x4x2_t cd = vtrnq_u32(c, d);
+        a = vcombine_u32(vget_low_u32(ab.val[0]), vget_low_u32(cd.val[0]));
+        b = vcombine_u32(vget_low_u32(ab.val[1]), vget_low_u32(cd.val[1]));
+        c = vcombine_u32(vget_high_u32(ab.val[0]), vget_high_u32(cd.val[0]));
+        d = vcombine_u32(vget_high_u32(ab.val[1]), vget_high_u32(cd.val[1]));
+    }
+};
+
+} // namespace
+
+void scrypt_romix_neon(uint32_t* B, int r, int N, int tmto, uint32_t* V, uint32_t* XY) {
+    scrypt_diag::romix_any<Neon>(B, r, N, tmto, V, XY);
+}
+
+void scrypt_romix_lanes_neon(uint32_t* const B[SCRYPT_LANES], int r, int N,
+                             uint32_t* V, uint32_t* XY) {
+    scrypt_lanes::romix_any<Neon>(B, r, N, V, XY);
+}
+
+#endif // SCRYPT_HAVE_NEON
@@ -0,0 +1,56 @@
+/**
+ * SSE2 scrypt: diagonal-layout single-stream ROMix, and four hashes
+ * through ROMix in lockstep, one per 32-bit lane. SSE2 is baseline on
+ * x86_64, so no CPUID check.
+ */
+
+#include "scrypt_impl.h"
+
+#if SCRYPT_HAVE_SSE2
+
+#include "scrypt_lanes.h"
+#include "scrypt_diag.h"
+#include <emmintrin.h>
+
+namespace {
+
+// 4 x 32-bit lanes for scrypt_lanes and scrypt_diag
+struct Sse2 {
+    typedef __m128i T;
+    
+    static inline T add(T a, T b) { return _mm_add_epi32(a, b); }
+    static inline T xor_(T a, T b) { return _mm_xor_si128(a, b); }
+    template <int n> static inline T rotl(T x) {
+        return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n));
+    }
+    static inline T load(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static inline void store(uint32_t* p, T x) { _mm_storeu_si128((__m128i*)p, x); }
+    
+    template <int n> static inline T shuffle(T x) {
+        return _mm_shuffle_epi32(x, _MM_SHUFFLE((n + 3) & 3, (n + 2) & 3, (n + 1) & 3, n));
+    }
+    
+    static inline void transpose(T& a, T& b, T& c, T& d) {
+        T ab0 = _mm_unpacklo_epi32(a, b);
+        T cd0 = _mm_unpacklo_epi32(c, d);
+        T ab1 = _mm_unpackhi_epi32(a, b);
+        T cd1 = _mm_unpackhi_epi32(c, d);
+        a = _mm_unpacklo_epi64(ab0, cd0);
+        b = _mm_unpackhi_epi64(ab0, cd0);
+        c = _mm_unpacklo_epi64(ab1, cd1);
+        d = _mm_unpackhi_epi64(ab1, cd1);
+    }
+};
+
+} // namespace
+
+void scrypt_romix_sse2(uint32_t* B, int r, int N, int tmto, uint32_t* V, uint32_t* XY) {
+    scrypt_diag::romix_any<Sse2>(B, r, N, tmto, V, XY);
+}
+
+void scrypt_romix_lanes_sse2(uint32_t* const B[SCRYPT_LANES], int r, int N,
+                             uint32_t* V, uint32_t* XY) {
+    scrypt_lanes::romix_any<Sse2>(B, r, N, V, XY);
+}
+
+#endif // SCRYPT_HAVE_SSE2
@@ -4,10 +4,16 @@
  */
 
 #include "sha256.h"
+#include "sha256_impl.h"
+#include "sha256_lanes.h"
 #include <cstring>
 
+#if SHA256_HAVE_X86
+#include "cpu_features.h"
+#endif
+
 // SHA256 constants (first 32 bits of fractional parts of cube roots of first 64 primes)
-static const uint32_t K[64] = {
+const uint32_t SHA256_K[64] = {
     0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
     0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
     0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
@@ -35,37 +41,14 @@ static const uint32_t H0[8] = {
 #define SIG0(x)      (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
 #define SIG1(x)      (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
 
-// Process a 64-byte block
-static void sha256_transform(uint32_t state[8], const uint8_t block[64]) {
-    uint32_t W[64];
-    uint32_t a, b, c, d, e, f, g, h;
+// Run rounds [first, last) over an expanded message schedule
+static inline void sha256_rounds(uint32_t v[8], const uint32_t W[64], int first, int last) {
+    uint32_t a = v[0], b = v[1], c = v[2], d = v[3];
+    uint32_t e = v[4], f = v[5], g = v[6], h = v[7];
     uint32_t t1, t2;
     
-    // Prepare message schedule
-    for (int i = 0; i < 16; i++) {
-        W[i] = ((uint32_t)block[i*4] << 24) |
-               ((uint32_t)block[i*4+1] << 16) |
-               ((uint32_t)block[i*4+2] << 8) |
-               ((uint32_t)block[i*4+3]);
-    }
-    
-    for (int i = 16; i < 64; i++) {
-        W[i] = SIG1(W[i-2]) + W[i-7] + SIG0(W[i-15]) + W[i-16];
-    }
-    
-    // Initialize working variables
-    a = state[0];
-    b = state[1];
-    c = state[2];
-    d = state[3];
-    e = state[4];
-    f = state[5];
-    g = state[6];
-    h = state[7];
-    
-    // 64 rounds
-    for (int i = 0; i < 64; i++) {
-        t1 = h + EP1(e) + CH(e, f, g) + K[i] + W[i];
+    for (int i = first; i < last; i++) {
+        t1 = h + EP1(e) + CH(e, f, g) + SHA256_K[i] + W[i];
         t2 = EP0(a) + MAJ(a, b, c);
         h = g;
         g = f;
@@ -77,65 +60,491 @@ static void sha256_transform(uint32_t state[8], const uint8_t block[64]) {
         a = t1 + t2;
     }
     
-    // Add compressed chunk to current hash value
-    state[0] += a;
-    state[1] += b;
-    state[2] += c;
-    state[3] += d;
-    state[4] += e;
-    state[5] += f;
-    state[6] += g;
-    state[7] += h;
+    v[0] = a; v[1] = b; v[2] = c; v[3] = d;
+    v[4] = e; v[5] = f; v[6] = g; v[7] = h;
+}
+
+// Expand message schedule words [first, 64)
+static inline void sha256_expand(uint32_t W[64], int first) {
+    for (int i = first; i < 64; i++) {
+        W[i] = SIG1(W[i-2]) + W[i-7] + SIG0(W[i-15]) + W[i-16];
+    }
+}
+
+static inline uint32_t load_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | ((uint32_t)p[3]);
+}
+
+static inline void store_be32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)(v);
+}
+
+// Portable compression of `count` consecutive 64-byte blocks
+static void sha256_blocks_scalar(uint32_t state[8], const uint8_t* blocks, size_t count) {
+    uint32_t W[64];
+    uint32_t v[8];
+    
+    for (; count > 0; count--, blocks += 64) {
+        // Prepare message schedule
+        for (int i = 0; i < 16; i++) {
+            W[i] = load_be32(blocks + i * 4);
+        }
+        sha256_expand(W, 16);
+        
+        memcpy(v, state, sizeof(v));
+        sha256_rounds(v, W, 0, 64);
+        
+        // Add compressed chunk to current hash value
+        for (int i = 0; i < 8; i++) {
+            state[i] += v[i];
+        }
+    }
+}
+
+// Compression kernels chosen once when the library is loaded
+struct Sha256Impl {
+    const char* name;
+    sha256_blocks_fn blocks;
+    // Single-block compression of pre-decoded words. Null for the scalar
+    // backend, where the midstate path runs its own precomputed rounds.
+    sha256_words_fn words;
+    // Multi-buffer SHA-256d for nonce scans, null if there is none
+    sha256d_lanes_fn sha256dLanes;
+    int lanes;
+};
+
+static Sha256Impl sha256_select_impl() {
+#if SHA256_HAVE_ARMV8
+    if (sha256_armv8_supported()) {
+        return { "armv8-ce", sha256_blocks_armv8, sha256_words_armv8, nullptr, 1 };
+    }
+#endif
+#if SHA256_HAVE_X86
+    // Eight interleaved lanes outrun single-stream SHA-NI on nonce scans,
+    // so AVX2 takes the scan path whenever both are present
+    bool shani = cpu_has_shani();
+    bool avx2 = cpu_has_avx2();
+    if (shani && avx2) {
+        return { "sha-ni+avx2x8", sha256_blocks_shani, sha256_words_shani, sha256d_lanes_avx2, 8 };
+    }
+    if (shani) {
+        return { "sha-ni", sha256_blocks_shani, sha256_words_shani, nullptr, 1 };
+    }
+    if (avx2) {
+        return { "avx2x8", sha256_blocks_scalar, nullptr, sha256d_lanes_avx2, 8 };
+    }
+#endif
+#if SHA256_HAVE_NEON
+    return { "neon4", sha256_blocks_scalar, nullptr, sha256d_lanes_neon, 4 };
+#else
+    return { "scalar", sha256_blocks_scalar, nullptr, nullptr, 1 };
+#endif
+}
+
+static const Sha256Impl impl = sha256_select_impl();
+
+const char* sha256_backend_name() {
+    return impl.name;
+}
+
+// Process a 64-byte block
+static inline void sha256_transform(uint32_t state[8], const uint8_t block[64]) {
+    impl.blocks(state, block, 1);
+}
+
+void sha256_init(Sha256Ctx* ctx) {
+    memcpy(ctx->state, H0, sizeof(H0));
+    ctx->length = 0;
+    ctx->bufferLen = 0;
+}
+
+void sha256_update(Sha256Ctx* ctx, const uint8_t* data, size_t len) {
+    ctx->length += len;
+    
+    // Top up a partially filled block first
+    if (ctx->bufferLen > 0) {
+        size_t take = 64 - ctx->bufferLen;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(ctx->buffer + ctx->bufferLen, data, take);
+        ctx->bufferLen += take;
+        data += take;
+        len -= take;
+        
+        if (ctx->bufferLen < 64) {
+            return;
+        }
+        sha256_transform(ctx->state, ctx->buffer);
+        ctx->bufferLen = 0;
+    }
+    
+    // Process full blocks straight from the input
+    if (len >= 64) {
+        size_t count = len / 64;
+        impl.blocks(ctx->state, data, count);
+        data += count * 64;
+        len -= count * 64;
+    }
+    
+    memcpy(ctx->buffer, data, len);
+    ctx->bufferLen = len;
+}
+
+void sha256_final(Sha256Ctx* ctx, uint8_t hash[32]) {
+    uint64_t bitLen = ctx->length * 8;
+    size_t n = ctx->bufferLen;
+    
+    // Append bit '1', then zeros up to the 8-byte length field
+    ctx->buffer[n++] = 0x80;
+    if (n > 56) {
+        memset(ctx->buffer + n, 0, 64 - n);
+        sha256_transform(ctx->state, ctx->buffer);
+        n = 0;
+    }
+    memset(ctx->buffer + n, 0, 56 - n);
+    
+    // Total message length in bits as 64-bit big-endian
+    store_be32(ctx->buffer + 56, (uint32_t)(bitLen >> 32));
+    store_be32(ctx->buffer + 60, (uint32_t)bitLen);
+    sha256_transform(ctx->state, ctx->buffer);
+    
+    // Produce final hash (big-endian)
+    for (int i = 0; i < 8; i++) {
+        store_be32(hash + i * 4, ctx->state[i]);
+    }
 }
 
 void sha256_hash(const uint8_t* data, size_t len, uint8_t* hash) {
-    uint32_t state[8];
-    uint8_t block[64];
-    size_t i;
+    Sha256Ctx ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, hash);
+}
+
+// Rounds 0-2 of the second block only consume W[0..2], so they are run once
+// per midstate together with the nonce-independent part of round 3
+static void midstate_precompute(Sha256dMidstate* ms) {
+    const uint32_t* W = ms->W;
+    uint32_t a = ms->state[0], b = ms->state[1], c = ms->state[2], d = ms->state[3];
+    uint32_t e = ms->state[4], f = ms->state[5], g = ms->state[6], h = ms->state[7];
+    for (int i = 0; i < 3; i++) {
+        uint32_t t1 = h + EP1(e) + CH(e, f, g) + SHA256_K[i] + W[i];
+        uint32_t t2 = EP0(a) + MAJ(a, b, c);
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    ms->pre[0] = a; ms->pre[1] = b; ms->pre[2] = c; ms->pre[3] = d;
+    ms->pre[4] = e; ms->pre[5] = f; ms->pre[6] = g; ms->pre[7] = h;
     
-    // Initialize state
-    memcpy(state, H0, sizeof(H0));
+    // Round 3 minus its W[3] term
+    ms->t1 = h + EP1(e) + CH(e, f, g) + SHA256_K[3];
+    ms->t2 = EP0(a) + MAJ(a, b, c);
+}
+
+static void midstate_first_block(Sha256dMidstate* ms, const uint8_t header[80]) {
+    memcpy(ms->state, H0, sizeof(H0));
+    sha256_transform(ms->state, header);
+}
+
+static void midstate_second_block(Sha256dMidstate* ms, const uint8_t header[80]) {
+    // Second block: header[64..79] followed by the padding of an 80-byte message.
+    // W[3] holds the nonce and is filled in per hash.
+    uint32_t* W = ms->W;
+    W[0] = load_be32(header + 64);
+    W[1] = load_be32(header + 68);
+    W[2] = load_be32(header + 72);
+    W[3] = 0;
+    W[4] = 0x80000000;
+    for (int i = 5; i < 15; i++) {
+        W[i] = 0;
+    }
+    W[15] = 80 * 8;
+    
+    // Schedule words that do not depend on W[3], and the constant parts of those that do
+    W[16] = SIG0(W[1]) + W[0];
+    W[17] = SIG1(W[15]) + SIG0(W[2]) + W[1];
+    ms->w18 = SIG1(W[16]) + W[2];
+    ms->w19 = SIG1(W[17]) + SIG0(W[4]);
+}
+
+void sha256d_midstate_init(Sha256dMidstate* ms, const uint8_t header[80]) {
+    // First block never changes for the lifetime of a job
+    midstate_first_block(ms, header);
+    midstate_second_block(ms, header);
+    midstate_precompute(ms);
+}
+
+void sha256d_midstate_set_first(Sha256dMidstate* ms, const uint8_t header[80]) {
+    midstate_first_block(ms, header);
+    midstate_precompute(ms);
+}
+
+void sha256d_midstate_set_second(Sha256dMidstate* ms, const uint8_t header[80]) {
+    midstate_second_block(ms, header);
+    midstate_precompute(ms);
+}
+
+// One 32-bit "lane", so the scalar path can share the fixed-length schedule
+// templates of the multi-buffer kernels
+struct Scalar {
+    typedef uint32_t T;
+    static T set1(uint32_t x) { return x; }
+    static T add(T a, T b) { return a + b; }
+    static T xor_(T a, T b) { return a ^ b; }
+    template <int n> static T shr(T x) { return x >> n; }
+    template <int n> static T rotr(T x) { return ROTR(x, n); }
+};
+
+// Full second-block schedule for one nonce. It only depends on header bytes
+// 64-79, so midstates that differ in the first block can share it.
+static inline void midstate_schedule(const Sha256dMidstate* ms, uint32_t w3, uint32_t W[64]) {
+    memcpy(W, ms->W, 18 * sizeof(uint32_t));
+    W[3] = w3;
+    W[18] = ms->w18 + SIG0(w3);
+    W[19] = ms->w19 + w3;
+    sha256_lanes::expand_final<Scalar, 80, 20>(W);
+}
+
+// Rounds 3-63 of the second block from the precomputed state. W2 receives
+// the message block of the outer SHA-256: the inner digest words and padding.
+static inline void midstate_inner(const Sha256dMidstate* ms, const uint32_t W[64], uint32_t W2[64]) {
+    uint32_t v[8];
+    
+    // Finish round 3, then continue from round 4
+    uint32_t t1 = ms->t1 + W[3];
+    v[0] = t1 + ms->t2;
+    v[1] = ms->pre[0];
+    v[2] = ms->pre[1];
+    v[3] = ms->pre[2];
+    v[4] = ms->pre[3] + t1;
+    v[5] = ms->pre[4];
+    v[6] = ms->pre[5];
+    v[7] = ms->pre[6];
+    sha256_rounds(v, W, 4, 64);
+    
+    // Second SHA-256 over the 32-byte digest, fed as words without serializing
+    for (int i = 0; i < 8; i++) {
+        W2[i] = ms->state[i] + v[i];
+    }
+    for (int i = 8; i < 16; i++) {
+        W2[i] = sha256_lanes::FinalBlock<32>::value(i);
+    }
+}
+
+static void midstate_finish(const Sha256dMidstate* ms, const uint32_t W[64], uint8_t hash[32]) {
+    uint32_t W2[64];
+    uint32_t v[8];
+    
+    midstate_inner(ms, W, W2);
+    sha256_lanes::expand_final<Scalar, 32, 16>(W2);
+    memcpy(v, H0, sizeof(H0));
+    sha256_rounds(v, W2, 0, 64);
+    
+    for (int i = 0; i < 8; i++) {
+        store_be32(hash + i * 4, H0[i] + v[i]);
+    }
+}
+
+// Last state word of the digest only. h after round 63 is e after round 60,
+// so the outer hash stops three rounds early.
+static uint32_t midstate_finish_h7(const Sha256dMidstate* ms, const uint32_t W[64]) {
+    uint32_t W2[64];
+    uint32_t v[8];
+    
+    midstate_inner(ms, W, W2);
+    sha256_lanes::expand_final<Scalar, 32, 16, 61>(W2);
+    memcpy(v, H0, sizeof(H0));
+    sha256_rounds(v, W2, 0, 61);
+    
+    return H0[7] + v[4];
+}
+
+static inline uint32_t bswap32(uint32_t x) {
+    return ((x & 0xFF) << 24) | ((x & 0xFF00) << 8) | ((x >> 8) & 0xFF00) | (x >> 24);
+}
+
+// SHA-256d state words with hardware rounds: round precomputation buys
+// nothing, only the midstate is reused
+static void midstate_words_hw(const Sha256dMidstate* ms, uint32_t w3, uint32_t v[8]) {
+    uint32_t W[16];
+    
+    memcpy(W, ms->W, sizeof(W));
+    W[3] = w3;
+    memcpy(v, ms->state, 8 * sizeof(uint32_t));
+    impl.words(v, W);
     
-    // Process full blocks
-    while (len >= 64) {
-        sha256_transform(state, data);
-        data += 64;
-        len -= 64;
+    memcpy(W, v, 8 * sizeof(uint32_t));
+    for (int i = 8; i < 16; i++) {
+        W[i] = sha256_lanes::FinalBlock<32>::value(i);
     }
+    memcpy(v, H0, sizeof(H0));
+    impl.words(v, W);
+}
+
+void sha256d_midstate_hash(const Sha256dMidstate* ms, uint32_t nonce, uint8_t hash[32]) {
+    // Nonce is stored little-endian in the header, SHA-256 reads big-endian words
+    uint32_t w3 = bswap32(nonce);
     
-    // Process final block with padding
-    memset(block, 0, 64);
-    memcpy(block, data, len);
-    block[len] = 0x80; // Append bit '1'
+    if (impl.words) {
+        uint32_t v[8];
+        midstate_words_hw(ms, w3, v);
+        for (int i = 0; i < 8; i++) {
+            store_be32(hash + i * 4, v[i]);
+        }
+        return;
+    }
     
-    if (len >= 56) {
-        // Need two blocks
-        sha256_transform(state, block);
-        memset(block, 0, 64);
+    uint32_t W[64];
+    midstate_schedule(ms, w3, W);
+    midstate_finish(ms, W, hash);
+}
+
+// Early-reject word for one nonce: the last state word of the digest
+static inline uint32_t midstate_h7(const Sha256dMidstate* ms, uint32_t nonce) {
+    if (impl.words) {
+        uint32_t v[8];
+        midstate_words_hw(ms, bswap32(nonce), v);
+        return v[7];
     }
     
-    // Append length in bits as 64-bit big-endian
-    uint64_t bitLen = (len + (data - (const uint8_t*)nullptr - len)) * 8;
-    // Simplified: just use the original length before processing
-    bitLen = len * 8 + ((data - (const uint8_t*)nullptr) / 64) * 512;
+    uint32_t W[64];
+    midstate_schedule(ms, bswap32(nonce), W);
+    return midstate_finish_h7(ms, W);
+}
+
+// Little-endian 256-bit compare, byte 31 most significant
+static inline bool below_target(const uint8_t hash[32], const uint8_t target[32]) {
+    for (int i = 31; i >= 0; i--) {
+        if (hash[i] != target[i]) {
+            return hash[i] < target[i];
+        }
+    }
+    return false;
+}
+
+// Target bytes 28-31 as a little-endian word: the most significant 32 bits
+static inline uint32_t target_top(const uint8_t target[32]) {
+    return (uint32_t)target[28] | ((uint32_t)target[29] << 8) |
+           ((uint32_t)target[30] << 16) | ((uint32_t)target[31] << 24);
+}
+
+// Digest bytes 28-31 are the last state word serialized big-endian, so the
+// digest can only be below target if its byte-swapped h7 is at most the top
+// word of the target. Everything else is rejected without serializing.
+static inline bool may_be_below(uint32_t h7, uint32_t top) {
+    return bswap32(h7) <= top;
+}
+
+bool sha256d_scan(const Sha256dMidstate* ms, uint32_t first, uint32_t last,
+                  const uint8_t target[32], uint32_t* found, uint64_t* hashes) {
+    uint8_t hash[32];
+    uint64_t done = 0;
+    uint64_t remaining = last >= first ? (uint64_t)last - first + 1 : 0;
+    uint32_t nonce = first;
+    uint32_t top = target_top(target);
     
-    // Actually, we need to track total bytes processed
-    // For simplicity, recalculate properly:
-    size_t totalLen = len; // This is remaining, need original
-    // Use a workaround - encode only the block length for now
-    uint64_t originalBits = len * 8;
+    if (impl.sha256dLanes) {
+        uint32_t h7[SHA256_MAX_LANES];
+        const int lanes = impl.lanes;
+        
+        while (remaining >= (uint64_t)lanes) {
+            impl.sha256dLanes(ms, nonce, h7);
+            for (int lane = 0; lane < lanes; lane++) {
+                if (!may_be_below(h7[lane], top)) {
+                    continue;
+                }
+                // Candidate: rehash in full for the 256-bit compare
+                sha256d_midstate_hash(ms, nonce + lane, hash);
+                if (below_target(hash, target)) {
+                    *found = nonce + lane;
+                    *hashes = done + lane + 1;
+                    return true;
+                }
+            }
+            nonce += lanes;
+            remaining -= lanes;
+            done += lanes;
+        }
+    }
     
-    for (i = 0; i < 8; i++) {
-        block[63 - i] = (uint8_t)(originalBits >> (i * 8));
+    // Single-stream path, also the tail of a multi-buffer scan
+    for (; remaining > 0; remaining--, nonce++) {
+        done++;
+        if (!may_be_below(midstate_h7(ms, nonce), top)) {
+            continue;
+        }
+        sha256d_midstate_hash(ms, nonce, hash);
+        if (below_target(hash, target)) {
+            *found = nonce;
+            *hashes = done;
+            return true;
+        }
     }
     
-    sha256_transform(state, block);
+    *hashes = done;
+    return false;
+}
+
+// Nonces per midstate between switches in a multi-midstate scan on backends
+// that cannot share the schedule; bounds the work skipped after a hit
+#define SCAN_MULTI_CHUNK 1024
+
+bool sha256d_scan_multi(const Sha256dMidstate* ms, int count, uint32_t first, uint32_t last,
+                        const uint8_t target[32], uint32_t* found, int* index,
+                        uint64_t* hashes) {
+    uint64_t done = 0;
+    uint64_t remaining = last >= first ? (uint64_t)last - first + 1 : 0;
+    uint32_t nonce = first;
+    
+    if (impl.words || impl.sha256dLanes) {
+        // Hardware schedules and lane kernels gain nothing from a shared
+        // schedule; interleave the midstates in chunks instead
+        while (remaining > 0) {
+            uint64_t chunk = remaining < SCAN_MULTI_CHUNK ? remaining : SCAN_MULTI_CHUNK;
+            uint32_t chunkLast = nonce + (uint32_t)(chunk - 1);
+            for (int i = 0; i < count; i++) {
+                uint64_t scanned = 0;
+                bool hit = sha256d_scan(&ms[i], nonce, chunkLast, target, found, &scanned);
+                done += scanned;
+                if (hit) {
+                    *index = i;
+                    *hashes = done;
+                    return true;
+                }
+            }
+            nonce += (uint32_t)chunk;
+            remaining -= chunk;
+        }
+        *hashes = done;
+        return false;
+    }
     
-    // Produce final hash (big-endian)
-    for (i = 0; i < 8; i++) {
-        hash[i*4]     = (uint8_t)(state[i] >> 24);
-        hash[i*4 + 1] = (uint8_t)(state[i] >> 16);
-        hash[i*4 + 2] = (uint8_t)(state[i] >> 8);
-        hash[i*4 + 3] = (uint8_t)(state[i]);
+    // Scalar: expand the second-block schedule once per nonce, run the rounds per midstate
+    uint32_t W[64];
+    uint8_t hash[32];
+    uint32_t top = target_top(target);
+    for (; remaining > 0; remaining--, nonce++) {
+        midstate_schedule(&ms[0], bswap32(nonce), W);
+        for (int i = 0; i < count; i++) {
+            done++;
+            if (!may_be_below(midstate_finish_h7(&ms[i], W), top)) {
+                continue;
+            }
+            midstate_finish(&ms[i], W, hash);
+            if (below_target(hash, target)) {
+                *found = nonce;
+                *index = i;
+                *hashes = done;
+                return true;
+            }
+        }
     }
+    
+    *hashes = done;
+    return false;
 }
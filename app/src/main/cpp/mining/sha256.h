@@ -5,7 +5,66 @@
 #include <cstddef>
 #include <cstring>
 
+// Streaming SHA-256. Contexts are plain values: copying one (or calling
+// sha256_clone) forks the hash, so a shared prefix is only absorbed once.
+struct Sha256Ctx {
+    uint32_t state[8];
+    uint8_t buffer[64];   // Pending bytes of an incomplete block
+    size_t bufferLen;
+    uint64_t length;      // Total bytes absorbed
+};
+
+void sha256_init(Sha256Ctx* ctx);
+void sha256_update(Sha256Ctx* ctx, const uint8_t* data, size_t len);
+void sha256_final(Sha256Ctx* ctx, uint8_t hash[32]);
+
+inline void sha256_clone(Sha256Ctx* dst, const Sha256Ctx* src) {
+    *dst = *src;
+}
+
 // SHA256 implementation optimized for ARM
 void sha256_hash(const uint8_t* data, size_t len, uint8_t* hash);
 
+// Name of the compression backend selected for this CPU (e.g. "armv8-ce")
+const char* sha256_backend_name();
+
+// Per-job SHA-256d state for 80-byte block headers.
+// The first 64-byte block and everything in the second block that does not
+// depend on the nonce (header bytes 76-79) are computed once.
+struct Sha256dMidstate {
+    uint32_t state[8];   // Chaining value after the first block
+    uint32_t pre[8];     // Working variables after rounds 0-2 of the second block
+    uint32_t W[18];      // Second-block schedule, W[3] (nonce) left empty
+    uint32_t w18, w19;   // Nonce-independent parts of W[18] and W[19]
+    uint32_t t1, t2;     // Round 3 temporaries without the W[3] term
+};
+
+void sha256d_midstate_init(Sha256dMidstate* ms, const uint8_t header[80]);
+
+// Refresh an initialized midstate after header bytes 0-63 changed (e.g. a
+// rolled version); the second-block schedule is kept
+void sha256d_midstate_set_first(Sha256dMidstate* ms, const uint8_t header[80]);
+
+// Refresh an initialized midstate after header bytes 64-75 changed (e.g. a
+// rolled ntime); the first-block state is kept
+void sha256d_midstate_set_second(Sha256dMidstate* ms, const uint8_t header[80]);
+
+// SHA256(SHA256(header)) with the given nonce in bytes 76-79 (little endian)
+void sha256d_midstate_hash(const Sha256dMidstate* ms, uint32_t nonce, uint8_t hash[32]);
+
+// Hash nonces first..last (inclusive) with the fastest available backend and
+// stop at the first digest below target (both read as little-endian 256-bit
+// numbers). Returns true with *found set on success; *hashes receives the
+// number of nonces hashed either way.
+bool sha256d_scan(const Sha256dMidstate* ms, uint32_t first, uint32_t last,
+                  const uint8_t target[32], uint32_t* found, uint64_t* hashes);
+
+// Scan nonces first..last under count midstates that differ only in their
+// first block (e.g. rolled versions) and so share one second-block schedule.
+// On a hit *index is the midstate it belongs to; *hashes counts hashes over
+// all midstates. Nonces after *found may be left unscanned for some midstates.
+bool sha256d_scan_multi(const Sha256dMidstate* ms, int count, uint32_t first, uint32_t last,
+                        const uint8_t target[32], uint32_t* found, int* index,
+                        uint64_t* hashes);
+
 #endif // SHA256_H
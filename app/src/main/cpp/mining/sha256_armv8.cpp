@@ -0,0 +1,74 @@
+/**
+ * SHA-256 compression using the ARMv8 SHA-2 crypto extension
+ * (SHA256H / SHA256H2 / SHA256SU0 / SHA256SU1)
+ */
+
+#include "sha256_impl.h"
+
+#if SHA256_HAVE_ARMV8
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+
+bool sha256_armv8_supported() {
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+}
+
+// 64 rounds on message vectors m[0..3], four rounds per SHA256H/H2 pair
+static inline void armv8_compress(uint32x4_t& abcd, uint32x4_t& efgh, uint32x4_t m[4]) {
+    uint32x4_t abcdSave = abcd;
+    uint32x4_t efghSave = efgh;
+    
+    #pragma unroll
+    for (int i = 0; i < 16; i++) {
+        uint32x4_t wk = vaddq_u32(m[i & 3], vld1q_u32(SHA256_K + i * 4));
+        if (i < 12) {
+            // W[i+16..i+19] from the previous 16 words
+            m[i & 3] = vsha256su1q_u32(vsha256su0q_u32(m[i & 3], m[(i + 1) & 3]),
+                                       m[(i + 2) & 3], m[(i + 3) & 3]);
+        }
+        uint32x4_t tmp = abcd;
+        abcd = vsha256hq_u32(abcd, efgh, wk);
+        efgh = vsha256h2q_u32(efgh, tmp, wk);
+    }
+    
+    abcd = vaddq_u32(abcd, abcdSave);
+    efgh = vaddq_u32(efgh, efghSave);
+}
+
+void sha256_blocks_armv8(uint32_t state[8], const uint8_t* blocks, size_t count) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32x4_t efgh = vld1q_u32(state + 4);
+    uint32x4_t m[4];
+    
+    for (; count > 0; count--, blocks += 64) {
+        // Blocks are big-endian byte streams
+        for (int i = 0; i < 4; i++) {
+            m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + i * 16)));
+        }
+        armv8_compress(abcd, efgh, m);
+    }
+    
+    vst1q_u32(state, abcd);
+    vst1q_u32(state + 4, efgh);
+}
+
+void sha256_words_armv8(uint32_t state[8], const uint32_t W[16]) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32x4_t efgh = vld1q_u32(state + 4);
+    uint32x4_t m[4];
+    
+    for (int i = 0; i < 4; i++) {
+        m[i] = vld1q_u32(W + i * 4);
+    }
+    armv8_compress(abcd, efgh, m);
+    
+    vst1q_u32(state, abcd);
+    vst1q_u32(state + 4, efgh);
+}
+
+#endif // SHA256_HAVE_ARMV8
@@ -0,0 +1,45 @@
+/**
+ * AVX2 multi-buffer SHA-256d: eight nonces per pass, one per 32-bit lane.
+ * Built with -mavx2; only called after sha256.cpp has checked CPUID.
+ */
+
+#include "sha256_impl.h"
+
+#if SHA256_HAVE_X86
+
+#include "sha256_lanes.h"
+#include <immintrin.h>
+
+namespace {
+
+// 8 x 32-bit lanes for sha256_lanes::sha256d
+struct Avx2 {
+    typedef __m256i T;
+    static const int LANES = 8;
+    
+    static inline T set1(uint32_t x) { return _mm256_set1_epi32((int)x); }
+    static inline T add(T a, T b) { return _mm256_add_epi32(a, b); }
+    static inline T xor_(T a, T b) { return _mm256_xor_si256(a, b); }
+    static inline T and_(T a, T b) { return _mm256_and_si256(a, b); }
+    static inline T andnot(T a, T b) { return _mm256_andnot_si256(a, b); }
+    template <int n> static inline T shr(T x) { return _mm256_srli_epi32(x, n); }
+    template <int n> static inline T rotr(T x) {
+        return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+    }
+    
+    static inline T nonces(uint32_t base) {
+        T n = _mm256_add_epi32(_mm256_set1_epi32((int)base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        return _mm256_shuffle_epi8(n, _mm256_broadcastsi128_si256(
+            _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL)));
+    }
+    
+    static inline void store(uint32_t* out, T x) { _mm256_storeu_si256((__m256i*)out, x); }
+};
+
+} // namespace
+
+void sha256d_lanes_avx2(const Sha256dMidstate* ms, uint32_t nonce, uint32_t* h7) {
+    sha256_lanes::sha256d<Avx2>(ms, nonce, h7);
+}
+
+#endif // SHA256_HAVE_X86
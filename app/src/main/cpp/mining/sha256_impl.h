@@ -0,0 +1,49 @@
+#ifndef SHA256_IMPL_H
+#define SHA256_IMPL_H
+
+#include <cstdint>
+#include <cstddef>
+#include "sha256.h"
+
+// Internal interface between sha256.cpp and the ISA-specific kernels.
+// Kernels are only compiled for targets whose toolchain can emit them;
+// whether the running CPU supports them is checked at load time.
+
+extern const uint32_t SHA256_K[64];
+
+// Compress `count` consecutive 64-byte blocks into state
+typedef void (*sha256_blocks_fn)(uint32_t state[8], const uint8_t* blocks, size_t count);
+
+// Compress one block given as 16 already-decoded big-endian words
+typedef void (*sha256_words_fn)(uint32_t state[8], const uint32_t W[16]);
+
+// Multi-buffer SHA-256d early-reject pass: h7[lane] = last state word of the
+// digest for nonce + lane. Candidates are rehashed in full by the caller.
+typedef void (*sha256d_lanes_fn)(const Sha256dMidstate* ms, uint32_t nonce, uint32_t* h7);
+
+// Widest lane count of any multi-buffer kernel
+#define SHA256_MAX_LANES 8
+
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#define SHA256_HAVE_ARMV8 1
+bool sha256_armv8_supported();
+void sha256_blocks_armv8(uint32_t state[8], const uint8_t* blocks, size_t count);
+void sha256_words_armv8(uint32_t state[8], const uint32_t W[16]);
+#endif
+
+// NEON is baseline on arm64 and enabled with -mfpu=neon on armeabi-v7a
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SHA256_HAVE_NEON 1
+void sha256d_lanes_neon(const Sha256dMidstate* ms, uint32_t nonce, uint32_t* h7);
+#endif
+
+// x86_64 kernels live in translation units built with extra ISA flags
+// (see CMakeLists.txt), which also defines X86_SIMD_KERNELS
+#if defined(__x86_64__) && defined(X86_SIMD_KERNELS)
+#define SHA256_HAVE_X86 1
+void sha256_blocks_shani(uint32_t state[8], const uint8_t* blocks, size_t count);
+void sha256_words_shani(uint32_t state[8], const uint32_t W[16]);
+void sha256d_lanes_avx2(const Sha256dMidstate* ms, uint32_t nonce, uint32_t* h7);
+#endif
+
+#endif // SHA256_IMPL_H
@@ -0,0 +1,193 @@
+#ifndef SHA256_LANES_H
+#define SHA256_LANES_H
+
+#include "sha256.h"
+#include "sha256_impl.h"
+
+// Lane-parallel SHA-256d over consecutive nonces, shared by the SIMD
+// backends. Each vector lane hashes the same header with its own nonce.
+// The fixed-length schedule helpers are also used by the scalar path.
+//
+// V provides the vector type and operations:
+//   T, LANES, set1, add, xor_, and_, andnot (~a & b), shr<n>, rotr<n>,
+//   nonces(base) -> byte-swapped {base, base+1, ...}, store(uint32_t*, T)
+// Include this only from a translation unit compiled for V's instruction set.
+
+namespace sha256_lanes {
+
+template <typename V, int n>
+static inline typename V::T rotr(typename V::T x) {
+    return V::template rotr<n>(x);
+}
+
+template <typename V>
+static inline typename V::T ep0(typename V::T x) {
+    return V::xor_(V::xor_(rotr<V, 2>(x), rotr<V, 13>(x)), rotr<V, 22>(x));
+}
+
+template <typename V>
+static inline typename V::T ep1(typename V::T x) {
+    return V::xor_(V::xor_(rotr<V, 6>(x), rotr<V, 11>(x)), rotr<V, 25>(x));
+}
+
+template <typename V>
+static inline typename V::T sig0(typename V::T x) {
+    return V::xor_(V::xor_(rotr<V, 7>(x), rotr<V, 18>(x)), V::template shr<3>(x));
+}
+
+template <typename V>
+static inline typename V::T sig1(typename V::T x) {
+    return V::xor_(V::xor_(rotr<V, 17>(x), rotr<V, 19>(x)), V::template shr<10>(x));
+}
+
+// Padding layout of the final block of a LEN-byte message that fits in one
+// block with its padding: the 0x80 marker word, zeros, then the bit length
+template <int LEN>
+struct FinalBlock {
+    static_assert(LEN % 4 == 0 && LEN % 64 < 56, "padding must fit in the final block");
+    static constexpr int PAD = (LEN % 64) / 4;
+    
+    static constexpr bool fixed(int i) {
+        return i >= PAD && i < 16;
+    }
+    static constexpr uint32_t value(int i) {
+        return i == PAD ? 0x80000000u : i == 15 ? (uint32_t)LEN * 8 : 0;
+    }
+};
+
+constexpr uint32_t rotr_c(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+constexpr uint32_t sig0_c(uint32_t x) {
+    return rotr_c(x, 7) ^ rotr_c(x, 18) ^ (x >> 3);
+}
+
+constexpr uint32_t sig1_c(uint32_t x) {
+    return rotr_c(x, 17) ^ rotr_c(x, 19) ^ (x >> 10);
+}
+
+// Schedule word I of the final block of a LEN-byte message. Terms that read
+// padding words are summed at compile time into one constant; terms that are
+// zero disappear (adding a zero constant folds away).
+template <typename V, int LEN, int I>
+static inline void expand_word(typename V::T W[64]) {
+    typedef FinalBlock<LEN> P;
+    constexpr uint32_t c = (P::fixed(I - 2) ? sig1_c(P::value(I - 2)) : 0) +
+                           (P::fixed(I - 7) ? P::value(I - 7) : 0) +
+                           (P::fixed(I - 15) ? sig0_c(P::value(I - 15)) : 0) +
+                           (P::fixed(I - 16) ? P::value(I - 16) : 0);
+    
+    typename V::T x = V::set1(c);
+    if constexpr (!P::fixed(I - 2)) {
+        x = V::add(x, sig1<V>(W[I - 2]));
+    }
+    if constexpr (!P::fixed(I - 7)) {
+        x = V::add(x, W[I - 7]);
+    }
+    if constexpr (!P::fixed(I - 15)) {
+        x = V::add(x, sig0<V>(W[I - 15]));
+    }
+    if constexpr (!P::fixed(I - 16)) {
+        x = V::add(x, W[I - 16]);
+    }
+    W[I] = x;
+}
+
+// Expand words [I, END) of the final block of a LEN-byte message, fully
+// unrolled. Only the message words and W[16..I) need to be filled in.
+template <typename V, int LEN, int I, int END = 64>
+static inline void expand_final(typename V::T W[64]) {
+    if constexpr (I < END) {
+        expand_word<V, LEN, I>(W);
+        expand_final<V, LEN, I + 1, END>(W);
+    }
+}
+
+template <typename V>
+static inline void rounds(typename V::T v[8], const typename V::T W[64], int first, int last) {
+    typedef typename V::T T;
+    T a = v[0], b = v[1], c = v[2], d = v[3];
+    T e = v[4], f = v[5], g = v[6], h = v[7];
+    
+    for (int i = first; i < last; i++) {
+        T ch = V::xor_(V::and_(e, f), V::andnot(e, g));
+        T maj = V::xor_(V::and_(a, b), V::and_(c, V::xor_(a, b)));
+        T t1 = V::add(V::add(h, ep1<V>(e)), V::add(ch, V::add(V::set1(SHA256_K[i]), W[i])));
+        T t2 = V::add(ep0<V>(a), maj);
+        h = g;
+        g = f;
+        f = e;
+        e = V::add(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = V::add(t1, t2);
+    }
+    
+    v[0] = a; v[1] = b; v[2] = c; v[3] = d;
+    v[4] = e; v[5] = f; v[6] = g; v[7] = h;
+}
+
+// h7[lane] = last state word of SHA-256d for nonce + lane (digest bytes
+// 28-31, the most significant ones as a mining target compares them)
+template <typename V>
+static inline void sha256d(const Sha256dMidstate* ms, uint32_t nonce, uint32_t* h7) {
+    static const uint32_t H0[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    typedef typename V::T T;
+    T W[64];
+    T v[8];
+    T h1[8];
+    
+    // Second block of the header, resuming from the precomputed round 3.
+    // Padding words are compile-time constants rather than loads.
+    T w3 = V::nonces(nonce);
+    for (int i = 0; i < 3; i++) {
+        W[i] = V::set1(ms->W[i]);
+    }
+    for (int i = 4; i < 16; i++) {
+        W[i] = V::set1(FinalBlock<80>::value(i));
+    }
+    W[16] = V::set1(ms->W[16]);
+    W[17] = V::set1(ms->W[17]);
+    W[3] = w3;
+    W[18] = V::add(V::set1(ms->w18), sig0<V>(w3));
+    W[19] = V::add(V::set1(ms->w19), w3);
+    expand_final<V, 80, 20>(W);
+    
+    T t1 = V::add(V::set1(ms->t1), w3);
+    v[0] = V::add(t1, V::set1(ms->t2));
+    v[1] = V::set1(ms->pre[0]);
+    v[2] = V::set1(ms->pre[1]);
+    v[3] = V::set1(ms->pre[2]);
+    v[4] = V::add(V::set1(ms->pre[3]), t1);
+    v[5] = V::set1(ms->pre[4]);
+    v[6] = V::set1(ms->pre[5]);
+    v[7] = V::set1(ms->pre[6]);
+    rounds<V>(v, W, 4, 64);
+    
+    for (int i = 0; i < 8; i++) {
+        h1[i] = V::add(V::set1(ms->state[i]), v[i]);
+    }
+    
+    // Second hash over the 32-byte digest. Its last state word is e after
+    // round 60, so rounds 61-63 and their schedule words are skipped.
+    for (int i = 0; i < 8; i++) {
+        W[i] = h1[i];
+        v[i] = V::set1(H0[i]);
+    }
+    for (int i = 8; i < 16; i++) {
+        W[i] = V::set1(FinalBlock<32>::value(i));
+    }
+    expand_final<V, 32, 16, 61>(W);
+    rounds<V>(v, W, 0, 61);
+    
+    V::store(h7, V::add(V::set1(H0[7]), v[4]));
+}
+
+} // namespace sha256_lanes
+
+#endif // SHA256_LANES_H
@@ -0,0 +1,44 @@
+/**
+ * NEON multi-buffer SHA-256d: four nonces per pass, one per 32-bit lane.
+ * Used on armeabi-v7a and on arm64 cores without the SHA-2 extension.
+ */
+
+#include "sha256_impl.h"
+
+#if SHA256_HAVE_NEON
+
+#include "sha256_lanes.h"
+#include <arm_neon.h>
+
+namespace {
+
+// 4 x 32-bit lanes for sha256_lanes::sha256d
+struct Neon {
+    typedef uint32x4_t T;
+    static const int LANES = 4;
+    
+    static inline T set1(uint32_t x) { return vdupq_n_u32(x); }
+    static inline T add(T a, T b) { return vaddq_u32(a, b); }
+    static inline T xor_(T a, T b) { return veorq_u32(a, b); }
+    static inline T and_(T a, T b) { return vandq_u32(a, b); }
+    static inline T andnot(T a, T b) { return vbicq_u32(b, a); }
+    template <int n> static inline T shr(T x) { return vshrq_n_u32(x, n); }
+    // Shift-right-and-insert saves the OR of a shift pair
+    template <int n> static inline T rotr(T x) { return vsriq_n_u32(vshlq_n_u32(x, 32 - n), x, n); }
+    
+    static inline T nonces(uint32_t base) {
+        static const uint32_t offsets[4] = { 0, 1, 2, 3 };
+        T n = vaddq_u32(vdupq_n_u32(base), vld1q_u32(offsets));
+        return vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(n)));
+    }
+    
+    static inline void store(uint32_t* out, T x) { vst1q_u32(out, x); }
+};
+
+} // namespace
+
+void sha256d_lanes_neon(const Sha256dMidstate* ms, uint32_t nonce, uint32_t* h7) {
+    sha256_lanes::sha256d<Neon>(ms, nonce, h7);
+}
+
+#endif // SHA256_HAVE_NEON
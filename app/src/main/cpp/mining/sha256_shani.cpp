@@ -0,0 +1,89 @@
+/**
+ * SHA-256 compression using the x86 SHA extensions (SHA-NI).
+ * Built with -msse4.1 -msha; only called after sha256.cpp has checked CPUID.
+ */
+
+#include "sha256_impl.h"
+
+#if SHA256_HAVE_X86
+
+#include <immintrin.h>
+
+namespace {
+
+// Byte-swap each 32-bit word
+inline __m128i bswap_mask() {
+    return _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+}
+
+// 64 rounds on message vectors m[0..3]. state0/state1 hold ABEF/CDGH.
+inline void shani_compress(__m128i& state0, __m128i& state1, __m128i m[4]) {
+    __m128i abefSave = state0;
+    __m128i cdghSave = state1;
+    __m128i msg, tmp;
+    
+    for (int i = 0; i < 16; i++) {
+        msg = _mm_add_epi32(m[i & 3], _mm_loadu_si128((const __m128i*)(SHA256_K + i * 4)));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        if (i >= 3 && i < 15) {
+            // Finish W for the next group of four rounds
+            tmp = _mm_alignr_epi8(m[i & 3], m[(i - 1) & 3], 4);
+            m[(i + 1) & 3] = _mm_add_epi32(m[(i + 1) & 3], tmp);
+            m[(i + 1) & 3] = _mm_sha256msg2_epu32(m[(i + 1) & 3], m[i & 3]);
+        }
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        if (i >= 1 && i < 13) {
+            m[(i - 1) & 3] = _mm_sha256msg1_epu32(m[(i - 1) & 3], m[i & 3]);
+        }
+    }
+    
+    state0 = _mm_add_epi32(state0, abefSave);
+    state1 = _mm_add_epi32(state1, cdghSave);
+}
+
+// state[0..7] -> ABEF / CDGH
+inline void shani_load(const uint32_t state[8], __m128i& state0, __m128i& state1) {
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0xB1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(state + 4)), 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+}
+
+inline void shani_store(uint32_t state[8], __m128i state0, __m128i state1) {
+    __m128i tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i*)state, _mm_blend_epi16(tmp, state1, 0xF0));
+    _mm_storeu_si128((__m128i*)(state + 4), _mm_alignr_epi8(state1, tmp, 8));
+}
+
+} // namespace
+
+void sha256_blocks_shani(uint32_t state[8], const uint8_t* blocks, size_t count) {
+    __m128i state0, state1;
+    __m128i m[4];
+    const __m128i mask = bswap_mask();
+    
+    shani_load(state, state0, state1);
+    for (; count > 0; count--, blocks += 64) {
+        for (int i = 0; i < 4; i++) {
+            m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + i * 16)), mask);
+        }
+        shani_compress(state0, state1, m);
+    }
+    shani_store(state, state0, state1);
+}
+
+void sha256_words_shani(uint32_t state[8], const uint32_t W[16]) {
+    __m128i state0, state1;
+    __m128i m[4];
+    
+    shani_load(state, state0, state1);
+    for (int i = 0; i < 4; i++) {
+        m[i] = _mm_loadu_si128((const __m128i*)(W + i * 4));
+    }
+    shani_compress(state0, state1, m);
+    shani_store(state, state0, state1);
+}
+
+#endif // SHA256_HAVE_X86
@@ -0,0 +1,101 @@
+/**
+ * Persistent worker threads shared by the parallel hash functions
+ */
+
+#include "thread_pool.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+// Concurrent callers queue on the same workers instead of each starting
+// their own. Workers are detached and the pool is never freed.
+struct ThreadPool {
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    int workers = 0;
+};
+
+// One thread_pool_run call's tasks still running
+struct ThreadPoolBatch {
+    std::mutex lock;
+    std::condition_variable done;
+    int pending = 0;
+};
+
+static ThreadPool* pool_get() {
+    static ThreadPool* pool = new ThreadPool();
+    return pool;
+}
+
+static void pool_worker(ThreadPool* pool) {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(pool->lock);
+            pool->wake.wait(guard, [pool] { return !pool->tasks.empty(); });
+            task = std::move(pool->tasks.front());
+            pool->tasks.pop_front();
+        }
+        task();
+    }
+}
+
+int thread_pool_threads(int requested, int limit) {
+    if (requested <= 0) {
+        requested = (int)std::thread::hardware_concurrency();
+    }
+    if (requested > THREAD_POOL_MAX_THREADS) {
+        requested = THREAD_POOL_MAX_THREADS;
+    }
+    if (requested > limit) {
+        requested = limit;
+    }
+    if (requested <= 1) {
+        return 1;
+    }
+    
+    // Start workers until there are requested - 1 of them
+    ThreadPool* pool = pool_get();
+    std::lock_guard<std::mutex> guard(pool->lock);
+    while (pool->workers < requested - 1) {
+        try {
+            std::thread(pool_worker, pool).detach();
+        } catch (const std::system_error&) {
+            break;
+        }
+        pool->workers++;
+    }
+    return requested < pool->workers + 1 ? requested : pool->workers + 1;
+}
+
+void thread_pool_run(int count, const std::function<void(int)>& task) {
+    if (count <= 0) {
+        return;
+    }
+    
+    ThreadPool* pool = pool_get();
+    ThreadPoolBatch batch;
+    batch.pending = count - 1;
+    if (count > 1) {
+        {
+            std::lock_guard<std::mutex> guard(pool->lock);
+            for (int i = 0; i < count - 1; i++) {
+                pool->tasks.emplace_back([i, &task, &batch] {
+                    task(i);
+                    std::lock_guard<std::mutex> done(batch.lock);
+                    if (--batch.pending == 0) {
+                        batch.done.notify_one();
+                    }
+                });
+            }
+        }
+        pool->wake.notify_all();
+    }
+    
+    task(count - 1);
+    std::unique_lock<std::mutex> guard(batch.lock);
+    batch.done.wait(guard, [&batch] { return batch.pending == 0; });
+}
@@ -0,0 +1,22 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <functional>
+
+// Most threads one parallel hash uses, the calling thread included
+#define THREAD_POOL_MAX_THREADS 8
+
+// Threads to split a job into when `requested` are asked for (0 or less for
+// one per CPU): at most THREAD_POOL_MAX_THREADS and limit, and no more than
+// the pool's workers plus the caller. Starts workers as needed; returns 1
+// if none can be started.
+int thread_pool_threads(int requested, int limit);
+
+// Run task(0) .. task(count - 1) and return once all have finished. All but
+// the last go to the shared workers, which live as long as the process, so
+// their thread_local state survives between calls; the last runs on the
+// calling thread. count should come from thread_pool_threads. Tasks must
+// not call thread_pool_run themselves.
+void thread_pool_run(int count, const std::function<void(int)>& task);
+
+#endif // THREAD_POOL_H
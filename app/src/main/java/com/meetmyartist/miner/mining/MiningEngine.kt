@@ -177,6 +177,7 @@ class MiningEngine @Inject constructor(
                     "EQUIHASH" -> performEquihashMining()
                     "KAWPOW" -> performKawPowMining()
                     "CRYPTONIGHT" -> performCryptoNightMining()
+                    "ALEPHIUM" -> performAlephiumMining()
                     else -> 0L
                 }
                 
@@ -297,21 +298,39 @@ class MiningEngine @Inject constructor(
         (500L * 1_000_000_000L / elapsed.coerceAtLeast(1))
     }
     
+    private suspend fun performAlephiumMining(): Long = withContext(Dispatchers.Default) {
+        if (!NativeMiner.isNativeAvailable()) {
+            delay(5)
+            return@withContext 0L
+        }
+        
+        val nonce = ByteArray(24).also { kotlin.random.Random.nextBytes(it) }
+        val header = ByteArray(300).also { kotlin.random.Random.nextBytes(it) } // About a real header blob
+        val target = ByteArray(32) // Unreachable, so the whole batch is hashed
+        val hashCount = LongArray(1)
+        
+        val startTime = System.nanoTime()
+        NativeMiner.mineBlake3Pow(nonce, header, target, 4, 0, 0, 0L, 99_999L, hashCount)
+        val elapsed = System.nanoTime() - startTime
+        
+        (hashCount[0] * 1_000_000_000L / elapsed.coerceAtLeast(1))
+    }
+    
     private suspend fun performScryptMining(): Long = withContext(Dispatchers.Default) {
         if (!NativeMiner.isNativeAvailable()) {
             delay(8)
             return@withContext 0L
         }
         
-        val input = generateMiningInput()
+        val header = generateMiningInput()
+        val target = ByteArray(32) // Unreachable, so the whole batch is hashed
+        val hashCount = LongArray(1)
         
         val startTime = System.nanoTime()
-        repeat(10) { // Scrypt is slow, batch 10
-            NativeMiner.scrypt(input, 1024, 1, 1) // Litecoin params
-        }
+        NativeMiner.mineScrypt(header, target, 0L, 39L, hashCount) // Scrypt is slow, batch 40
         val elapsed = System.nanoTime() - startTime
         
-        (10L * 1_000_000_000L / elapsed.coerceAtLeast(1))
+        (hashCount[0] * 1_000_000_000L / elapsed.coerceAtLeast(1))
     }
     
     private suspend fun performEquihashMining(): Long = withContext(Dispatchers.Default) {
@@ -59,6 +59,93 @@ object NativeMiner {
         hashCountOut: LongArray
     ): Long
     
+    /**
+     * Build a native job template from decoded Stratum job fields
+     * @param coinbase1 decoded coinb1
+     * @param extranonce1 decoded extranonce1 from mining.subscribe
+     * @param extranonce2Size extranonce2 size in bytes
+     * @param coinbase2 decoded coinb2
+     * @param merkleBranch concatenated 32-byte Merkle branch hashes
+     * @param version block version (numeric value of the hex field)
+     * @param prevHash 32-byte prevhash as sent by the pool
+     * @param ntime block time (numeric value of the hex field)
+     * @param nbits compact target (numeric value of the hex field)
+     * @param versionMask version bits negotiated via mining.configure, 0 to keep the version
+     * @param ntimeRoll seconds ntime may be advanced past the job's, 0 to keep it
+     * @return template handle, or 0 if the job is malformed
+     */
+    external fun createJobTemplate(
+        coinbase1: ByteArray,
+        extranonce1: ByteArray,
+        extranonce2Size: Int,
+        coinbase2: ByteArray,
+        merkleBranch: ByteArray,
+        version: Int,
+        prevHash: ByteArray,
+        ntime: Int,
+        nbits: Int,
+        versionMask: Int,
+        ntimeRoll: Int
+    ): Long
+    
+    /**
+     * 80-byte block header for a job template with the given extranonce2.
+     * The Merkle root is computed natively; nonce bytes are left zero.
+     */
+    external fun jobTemplateHeader(handle: Long, extranonce2: ByteArray): ByteArray?
+    
+    /**
+     * Drop the caller's reference to a template created by [createJobTemplate].
+     * Workers created from it keep it alive until they are released.
+     */
+    external fun releaseJobTemplate(handle: Long)
+    
+    /**
+     * Create a per-thread search state on a shared job template.
+     * Workers draw extranonce2 values from one atomic counter in the template,
+     * so no two workers ever search the same coinbase.
+     * @return worker handle, or 0 on failure
+     */
+    external fun createJobWorker(templateHandle: Long): Long
+    
+    /**
+     * Scan up to maxHashes headers. When the 32-bit nonce space is drained the
+     * worker rolls the version bits, then ntime, and only then moves to a new
+     * extranonce2, recomputing the coinbase hash and Merkle path.
+     * @return found nonce, -1 if none found, or [JOB_EXHAUSTED] when the
+     *         job's extranonce2 space is used up
+     */
+    external fun jobWorkerScan(
+        workerHandle: Long,
+        target: ByteArray,
+        maxHashes: Long,
+        hashCountOut: LongArray
+    ): Long
+    
+    /**
+     * Extranonce2 the worker is searching; a nonce returned by [jobWorkerScan]
+     * belongs to this value
+     */
+    external fun jobWorkerExtranonce2(workerHandle: Long): ByteArray
+    
+    /**
+     * Block version a nonce returned by [jobWorkerScan] belongs to
+     */
+    external fun jobWorkerVersion(workerHandle: Long): Int
+    
+    /**
+     * Ntime a nonce returned by [jobWorkerScan] belongs to
+     */
+    external fun jobWorkerNtime(workerHandle: Long): Int
+    
+    /**
+     * Free a worker created by [createJobWorker]
+     */
+    external fun releaseJobWorker(workerHandle: Long)
+    
+    /** [jobWorkerScan] result when no extranonce2 values are left */
+    const val JOB_EXHAUSTED = -2L
+    
     /**
      * Blake3 hash (fast, modern algorithm)
      */
@@ -81,6 +168,48 @@ object NativeMiner {
         hashCountOut: LongArray
     ): Long
     
+    /**
+     * Alephium-style BLAKE3 proof of work: BLAKE3(BLAKE3(nonce || header))
+     * @param nonce 24-byte nonce; bytes 0-7 are replaced by the searched counter
+     * @param header header blob that follows the nonce
+     * @param target big-endian target, up to 32 bytes
+     * @param groups number of shard groups
+     * @param fromGroup chain source group the hash must fall in
+     * @param toGroup chain destination group the hash must fall in
+     * @param startNonce first counter value
+     * @param endNonce last counter value
+     * @param hashCountOut array to receive hash count
+     * @return found counter or -1
+     */
+    external fun mineBlake3Pow(
+        nonce: ByteArray,
+        header: ByteArray,
+        target: ByteArray,
+        groups: Int,
+        fromGroup: Int,
+        toGroup: Int,
+        startNonce: Long,
+        endNonce: Long,
+        hashCountOut: LongArray
+    ): Long
+    
+    /**
+     * Mine Litecoin-style scrypt(1024, 1, 1) with nonce range
+     * @param blockHeader 80-byte block header
+     * @param target 32-byte little-endian target
+     * @param startNonce starting nonce value
+     * @param endNonce ending nonce value
+     * @param hashCountOut array to receive hash count performed
+     * @return found nonce or -1 if not found
+     */
+    external fun mineScrypt(
+        blockHeader: ByteArray,
+        target: ByteArray,
+        startNonce: Long,
+        endNonce: Long,
+        hashCountOut: LongArray
+    ): Long
+    
     /**
      * Scrypt hash (memory-hard, used by Litecoin)
      * @param input data to hash
@@ -90,6 +219,13 @@ object NativeMiner {
      */
     external fun scrypt(input: ByteArray, n: Int, r: Int, p: Int): ByteArray
     
+    /**
+     * Scrypt time-memory tradeoff: keep every factor-th block of the scratch
+     * table and recompute the rest, trading hashes for cache footprint
+     * @param factor 1 keeps the whole table, 0 picks one from each core's L2 size
+     */
+    external fun setScryptTmto(factor: Int)
+    
     /**
      * RandomX light mode hash (used by Monero)
      * Light mode uses significantly less memory but is slower.
@@ -28,6 +28,12 @@ class RealMiningWorker @Inject constructor(
     private var totalHashes = 0L
     private var lastHashCountTime = System.currentTimeMillis()
     
+    // Native template of the current pool job, shared by all worker threads
+    private val templateLock = Any()
+    private var currentTemplate: SharedTemplate? = null
+    
+    private data class SharedTemplate(val jobId: String, val handle: Long, val versionMask: Int)
+    
     fun startWorkers(threadCount: Int) {
         stopWorkers()
         
@@ -48,6 +54,7 @@ class RealMiningWorker @Inject constructor(
         workers.forEach { it.cancel() }
         workers.clear()
         totalHashes = 0L
+        releaseTemplate()
     }
     
     private suspend fun workerLoop(threadId: Int) {
@@ -72,53 +79,149 @@ class RealMiningWorker @Inject constructor(
     }
     
     private suspend fun mineJob(job: StratumClient.MiningJob, threadId: Int) {
-        // Generate unique extranonce2 for this thread
-        val extranonce2 = CryptoHasher.generateExtranonce2(
-            poolConnectionManager.getConnectionState().value.let { 
-                4 // Default size, should get from pool
+        val target = CryptoHasher.calculateTarget(job.nbits)
+        
+        if (!NativeMiner.isNativeAvailable()) {
+            // Generate unique extranonce2 for this thread
+            val extranonce2Size = poolConnectionManager.getExtranonce2Size().takeIf { it > 0 } ?: 4
+            val extranonce2 = CryptoHasher.generateExtranonce2(extranonce2Size)
+            
+            // Starting nonce for this thread
+            val nonceStart = 0xFFFFFFFFL / 100 * threadId
+            val nonceEnd = 0xFFFFFFFFL / 100 * (threadId + 1)
+            
+            mineJobFallback(job, extranonce2, target, nonceStart, nonceEnd)
+            return
+        }
+        
+        // Each worker searches the full nonce, version and ntime space of its
+        // own extranonce2, handed out natively from the shared job template
+        val (template, worker) = acquireJobWorker(job) ?: (null to 0L)
+        if (template == null || worker == 0L) {
+            // A job the pool has already replaced is dropped without waiting
+            if (poolConnectionManager.getCurrentJob().value?.jobId == job.jobId) {
+                delay(1000)
             }
-        )
+            return
+        }
         
-        // Starting nonce for this thread
-        var nonce = (0xFFFFFFFF / 100 * threadId).toUInt()
-        val nonceEnd = (0xFFFFFFFF / 100 * (threadId + 1)).toUInt()
+        try {
+            val hashCount = LongArray(1)
+            
+            while (currentCoroutineContext().isActive &&
+                   poolConnectionManager.getCurrentJob().value?.jobId == job.jobId) {
+                val found = NativeMiner.jobWorkerScan(worker, target, NONCE_BATCH, hashCount)
+                totalHashes += hashCount[0]
+                
+                if (found >= 0) {
+                    // Found valid share!
+                    val versionMask = template.versionMask
+                    submitShare(
+                        job.jobId,
+                        CryptoHasher.byteArrayToHexString(NativeMiner.jobWorkerExtranonce2(worker)),
+                        toHex32(NativeMiner.jobWorkerNtime(worker)),
+                        found.toString(16).padStart(8, '0'),
+                        if (versionMask != 0) toHex32(NativeMiner.jobWorkerVersion(worker) and versionMask) else null
+                    )
+                } else if (found == NativeMiner.JOB_EXHAUSTED) {
+                    // Nothing left to search until the pool sends a new job
+                    while (currentCoroutineContext().isActive &&
+                           poolConnectionManager.getCurrentJob().value?.jobId == job.jobId) {
+                        delay(1000)
+                    }
+                    break
+                }
+                
+                // Yield between batches to allow other operations
+                yield()
+            }
+        } finally {
+            NativeMiner.releaseJobWorker(worker)
+        }
+    }
+    
+    /**
+     * Create a native worker on the template for this job, building the
+     * template the first time any thread sees the job. Returns null once the
+     * pool has moved on, so a late thread never replaces the new job's
+     * template (and restarts its extranonce2 counter) with a stale one.
+     */
+    private fun acquireJobWorker(job: StratumClient.MiningJob): Pair<SharedTemplate, Long>? = synchronized(templateLock) {
+        if (job.jobId != poolConnectionManager.getCurrentJob().value?.jobId) {
+            return@synchronized null
+        }
         
-        while (currentCoroutineContext().isActive && nonce < nonceEnd) {
-            // Build coinbase
-            val coinbase = CryptoHasher.buildCoinbase(
-                job.coinbase1,
-                poolConnectionManager.getConnectionState().value.let { "" }, // extranonce1 from pool
-                extranonce2,
-                job.coinbase2
-            )
+        val cached = currentTemplate
+        val template = if (cached != null && cached.jobId == job.jobId) {
+            cached
+        } else {
+            cached?.let { NativeMiner.releaseJobTemplate(it.handle) }
+            currentTemplate = null
             
-            // Calculate merkle root
-            val merkleRoot = CryptoHasher.calculateMerkleRoot(coinbase, job.merkleBranch)
+            val versionMask = poolConnectionManager.getVersionRollingMask()
             
-            // Build block header
-            val header = CryptoHasher.buildBlockHeader(
-                job.version,
-                job.prevHash,
-                merkleRoot,
-                job.ntime,
-                job.nbits,
-                nonce.toString(16).padStart(8, '0')
+            // Decode the job once; coinbase, Merkle root and header are built natively
+            val handle = NativeMiner.createJobTemplate(
+                CryptoHasher.hexStringToByteArray(job.coinbase1),
+                CryptoHasher.hexStringToByteArray(poolConnectionManager.getExtranonce1()),
+                poolConnectionManager.getExtranonce2Size().takeIf { it > 0 } ?: 4,
+                CryptoHasher.hexStringToByteArray(job.coinbase2),
+                job.merkleBranch.fold(ByteArray(0)) { acc, branch ->
+                    acc + CryptoHasher.hexStringToByteArray(branch)
+                },
+                job.version.toLong(16).toInt(),
+                CryptoHasher.hexStringToByteArray(job.prevHash),
+                job.ntime.toLong(16).toInt(),
+                job.nbits.toLong(16).toInt(),
+                versionMask,
+                NTIME_ROLL_SECONDS
             )
+            if (handle == 0L) return@synchronized null
+            SharedTemplate(job.jobId, handle, versionMask).also { currentTemplate = it }
+        }
+        
+        template to NativeMiner.createJobWorker(template.handle)
+    }
+    
+    private fun releaseTemplate() = synchronized(templateLock) {
+        currentTemplate?.let { NativeMiner.releaseJobTemplate(it.handle) }
+        currentTemplate = null
+    }
+    
+    private suspend fun mineJobFallback(
+        job: StratumClient.MiningJob,
+        extranonce2: String,
+        target: ByteArray,
+        nonceStart: Long,
+        nonceEnd: Long
+    ) {
+        // Coinbase and Merkle root only depend on extranonce2
+        val coinbase = CryptoHasher.buildCoinbase(
+            job.coinbase1,
+            poolConnectionManager.getExtranonce1(),
+            extranonce2,
+            job.coinbase2
+        )
+        val merkleRoot = CryptoHasher.calculateMerkleRoot(coinbase, job.merkleBranch)
+        val header = CryptoHasher.buildBlockHeader(
+            job.version,
+            job.prevHash,
+            merkleRoot,
+            job.ntime,
+            job.nbits,
+            "00000000"
+        )
+        
+        var nonce = nonceStart
+        while (currentCoroutineContext().isActive && nonce < nonceEnd) {
+            header[76] = (nonce and 0xFF).toByte()
+            header[77] = ((nonce shr 8) and 0xFF).toByte()
+            header[78] = ((nonce shr 16) and 0xFF).toByte()
+            header[79] = ((nonce shr 24) and 0xFF).toByte()
             
-            // Hash the header
             val hash = CryptoHasher.sha256d(header)
-            
-            // Check if hash meets target
-            val target = CryptoHasher.calculateTarget(job.nbits)
-            
             if (CryptoHasher.meetsTarget(hash, target)) {
-                // Found valid share!
-                submitShare(
-                    job.jobId,
-                    extranonce2,
-                    job.ntime,
-                    nonce.toString(16).padStart(8, '0')
-                )
+                submitShare(job.jobId, extranonce2, job.ntime, nonce.toString(16).padStart(8, '0'))
             }
             
             nonce++
@@ -135,11 +238,15 @@ class RealMiningWorker @Inject constructor(
         jobId: String,
         extranonce2: String,
         ntime: String,
-        nonce: String
+        nonce: String,
+        versionBits: String? = null
     ) {
-        poolConnectionManager.submitShare(jobId, extranonce2, ntime, nonce)
+        poolConnectionManager.submitShare(jobId, extranonce2, ntime, nonce, versionBits)
     }
     
+    private fun toHex32(value: Int): String =
+        (value.toLong() and 0xFFFFFFFFL).toString(16).padStart(8, '0')
+    
     private suspend fun calculateHashrate() {
         while (currentCoroutineContext().isActive) {
             delay(2000) // Update every 2 seconds
@@ -158,4 +265,13 @@ class RealMiningWorker @Inject constructor(
     }
     
     fun getTotalHashes(): Long = totalHashes
+    
+    companion object {
+        // Nonces per native call; keeps cancellation and job switches responsive
+        private const val NONCE_BATCH = 0x40000L
+        
+        // How far ntime may be advanced once the version space of an
+        // extranonce2 is drained; well inside every pool's tolerance
+        private const val NTIME_ROLL_SECONDS = 60
+    }
 }
@@ -109,13 +109,17 @@ class PoolConnectionManager @Inject constructor(
         jobId: String,
         extranonce2: String,
         ntime: String,
-        nonce: String
+        nonce: String,
+        versionBits: String? = null
     ): Boolean {
-        return stratumClient.submitShare(jobId, extranonce2, ntime, nonce)
+        return stratumClient.submitShare(jobId, extranonce2, ntime, nonce, versionBits)
     }
     
     fun getConnectionState() = stratumClient.connectionState
     fun getCurrentJob() = stratumClient.currentJob
+    fun getExtranonce1() = stratumClient.getExtranonce1()
+    fun getExtranonce2Size() = stratumClient.getExtranonce2Size()
+    fun getVersionRollingMask() = stratumClient.getVersionRollingMask()
     fun getDifficulty() = stratumClient.difficulty
     fun getSubmittedShares() = stratumClient.submittedShares
     fun getAcceptedShares() = stratumClient.acceptedShares
@@ -49,6 +49,7 @@ class StratumClient @Inject constructor() {
     
     private var extranonce1: String = ""
     private var extranonce2Size: Int = 0
+    private var versionRollingMask: Int = 0
     private var host: String = ""
     private var port: Int = 0
     
@@ -93,7 +94,8 @@ class StratumClient @Inject constructor() {
                 // Start listening for messages
                 receiveJob = launch { receiveMessages() }
                 
-                // Subscribe and authorize
+                // Negotiate version rolling, then subscribe and authorize
+                configure()
                 subscribe(host, port)
                 authorize("$walletAddress.$workerName", password)
                 
@@ -121,6 +123,21 @@ class StratumClient @Inject constructor() {
         _connectionState.value = ConnectionState.Disconnected
     }
     
+    private suspend fun configure() {
+        versionRollingMask = 0
+        val request = buildJsonRpcRequest(
+            method = "mining.configure",
+            params = listOf(
+                listOf("version-rolling"),
+                mapOf(
+                    "version-rolling.mask" to VERSION_ROLLING_MASK,
+                    "version-rolling.min-bit-count" to 2
+                )
+            )
+        )
+        sendMessage(request)
+    }
+    
     private suspend fun subscribe(host: String, port: Int) {
         val request = buildJsonRpcRequest(
             method = "mining.subscribe",
@@ -141,18 +158,23 @@ class StratumClient @Inject constructor() {
         jobId: String,
         extranonce2: String,
         ntime: String,
-        nonce: String
+        nonce: String,
+        versionBits: String? = null
     ): Boolean {
         return try {
+            val params = mutableListOf<Any?>(
+                extranonce1,
+                extranonce2,
+                ntime,
+                nonce,
+                jobId
+            )
+            // BIP 310: rolled version bits go in a sixth parameter
+            versionBits?.let { params.add(it) }
+            
             val request = buildJsonRpcRequest(
                 method = "mining.submit",
-                params = listOf(
-                    extranonce1,
-                    extranonce2,
-                    ntime,
-                    nonce,
-                    jobId
-                )
+                params = params
             )
             
             sendMessage(request)
@@ -211,6 +233,13 @@ class StratumClient @Inject constructor() {
                         }
                     }
                     
+                    "mining.set_version_mask" -> {
+                        // Pool changed the version bits it lets us roll
+                        if (params.size() > 0) {
+                            versionRollingMask = params.get(0).asString.toLong(16).toInt()
+                        }
+                    }
+                    
                     "client.reconnect" -> {
                         // Pool requests reconnection
                         // Handle reconnection logic
@@ -222,6 +251,17 @@ class StratumClient @Inject constructor() {
                 val id = json.get("id").asInt
                 
                 when {
+                    // Configure response
+                    result.isJsonObject && result.asJsonObject.has("version-rolling") -> {
+                        val configured = result.asJsonObject
+                        versionRollingMask = if (configured.get("version-rolling").asBoolean &&
+                                                 configured.has("version-rolling.mask")) {
+                            configured.get("version-rolling.mask").asString.toLong(16).toInt()
+                        } else {
+                            0
+                        }
+                    }
+                    
                     // Subscribe response
                     result.isJsonArray && result.asJsonArray.size() >= 2 -> {
                         val subscriptionDetails = result.asJsonArray
@@ -279,4 +319,10 @@ class StratumClient @Inject constructor() {
     
     fun getExtranonce1(): String = extranonce1
     fun getExtranonce2Size(): Int = extranonce2Size
+    fun getVersionRollingMask(): Int = versionRollingMask
+    
+    companion object {
+        // BIP 320 general-purpose version bits
+        private const val VERSION_ROLLING_MASK = "1fffe000"
+    }
 }